@@ -210,6 +210,7 @@ static struct fbtft_display display = {
 	.gamma_num = 2,
 	.gamma_len = 15,
 	.gamma = DEFAULT_GAMMA,
+	.caps = FBTFT_CAP_ADDR_WIN_X,
 	.fbtftops = {
 		.init_display = init_display,
 		.set_addr_win = set_addr_win,
@@ -76,21 +76,6 @@ static int init_display(struct fbtft_par *par)
 	return 0;
 };
 
-static void set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
-{
-	fbtft_par_dbg(DEBUG_SET_ADDR_WIN, par,
-		"%s(xs=%d, ys=%d, xe=%d, ye=%d)\n", __func__, xs, ys, xe, ye);
-
-	/* column address */
-	write_reg(par, 0x2a, xs >> 8, xs & 0xff, xe >> 8, xe & 0xff);
-
-	/* row adress */
-	write_reg(par, 0x2b, ys >> 8, ys & 0xff, ye >> 8, ye & 0xff);
-
-	/* memory write */
-	write_reg(par, 0x2c);
-}
-
 #define my (1 << 7)
 #define mx (1 << 6)
 #define mv (1 << 5)
@@ -127,14 +112,15 @@ static int set_var(struct fbtft_par *par)
 */
 static int set_gamma(struct fbtft_par *par, unsigned long *curves)
 {
+	u16 vals[1 + 19];
+	int i;
+
 	fbtft_par_dbg(DEBUG_INIT_DISPLAY, par, "%s()\n", __func__);
 
-	write_reg(par, 0xE0,
-		curves[0], curves[1], curves[2], curves[3],
-		curves[4], curves[5], curves[6], curves[7],
-		curves[8], curves[9], curves[10], curves[11],
-		curves[12], curves[13], curves[14], curves[15],
-		curves[16], curves[17], curves[18]);
+	vals[0] = 0xE0;
+	for (i = 0; i < 19; i++)
+		vals[1 + i] = curves[i];
+	write_reg_buf(par, vals, ARRAY_SIZE(vals));
 
 	return 0;
 }
@@ -147,9 +133,9 @@ static struct fbtft_display display = {
 	.gamma_num = 1,
 	.gamma_len = 19,
 	.gamma = DEFAULT_GAMMA,
+	.caps = FBTFT_CAP_ADDR_WIN_X | FBTFT_CAP_TE,
 	.fbtftops = {
 		.init_display = init_display,
-		.set_addr_win = set_addr_win,
 		.set_var = set_var,
 		.set_gamma = set_gamma,
 	},
@@ -178,6 +178,13 @@ static void set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
 {
 	fbtft_par_dbg(DEBUG_SET_ADDR_WIN, par,
 		"%s(xs=%d, ys=%d, xe=%d, ye=%d)\n", __func__, xs, ys, xe, ye);
+
+	/* the address counter is already there */
+	if (fbtft_addr_win_continues(par, xs, ys, xe, ye)) {
+		write_reg(par, 0x0022);
+		return;
+	}
+
 	switch (par->info->var.rotate) {
 	/* R20h = Horizontal GRAM Start Address */
 	/* R21h = Vertical GRAM Start Address */
@@ -199,6 +206,9 @@ static void set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
 		break;
 	}
 	write_reg(par, 0x0022); /* Write Data to GRAM */
+
+	/* it runs on to the end of the display */
+	fbtft_addr_win_set(par, xs, ys, xe, par->info->var.yres - 1);
 }
 
 static int set_var(struct fbtft_par *par)
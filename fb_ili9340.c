@@ -62,6 +62,10 @@ static int init_display(struct fbtft_par *par)
 	/* 16 bits/pixel */
 	write_reg(par, 0x3A, 0x55);
 
+	/* Interface Control: little endian RGB565 */
+	if (par->littleendian)
+		write_reg(par, 0xF6, 0x01, 0x00, 0x20);
+
 	/* Frame Rate Control */
 	/* Division ratio = fosc, Frame Rate = 79Hz */
 	write_reg(par, 0xB1, 0x00, 0x18);
@@ -96,21 +100,6 @@ static int init_display(struct fbtft_par *par)
 	return 0;
 }
 
-static void set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
-{
-	fbtft_par_dbg(DEBUG_SET_ADDR_WIN, par,
-		"%s(xs=%d, ys=%d, xe=%d, ye=%d)\n", __func__, xs, ys, xe, ye);
-
-	/* Column address */
-	write_reg(par, 0x2A, xs >> 8, xs & 0xFF, xe >> 8, xe & 0xFF);
-
-	/* Row adress */
-	write_reg(par, 0x2B, ys >> 8, ys & 0xFF, ye >> 8, ye & 0xFF);
-
-	/* Memory write */
-	write_reg(par, 0x2C);
-}
-
 #define ILI9340_MADCTL_MV  0x20
 #define ILI9340_MADCTL_MX  0x40
 #define ILI9340_MADCTL_MY  0x80
@@ -140,15 +129,30 @@ static int set_var(struct fbtft_par *par)
 	return 0;
 }
 
+/* Vertical scrolling, rows are written bottom up (MY) at 180 degrees */
+static int set_scroll(struct fbtft_par *par, unsigned yoffset)
+{
+	unsigned yres = par->info->var.yres;
+
+	if (par->info->var.rotate == 180)
+		yoffset = (yres - yoffset) % yres;
+
+	fbtft_set_scroll_dcs(par, HEIGHT, yoffset);
+
+	return 0;
+}
+
 
 static struct fbtft_display display = {
 	.regwidth = 8,
 	.width = WIDTH,
 	.height = HEIGHT,
+	.caps = FBTFT_CAP_ADDR_WIN_X | FBTFT_CAP_TE |
+		FBTFT_CAP_LITTLE_ENDIAN | FBTFT_CAP_RAMWR_CONT,
 	.fbtftops = {
 		.init_display = init_display,
-		.set_addr_win = set_addr_win,
 		.set_var = set_var,
+		.set_scroll = set_scroll,
 	},
 };
 FBTFT_REGISTER_DRIVER(DRVNAME, "ilitek,ili9340", &display);
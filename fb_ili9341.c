@@ -64,6 +64,8 @@ static int init_display(struct fbtft_par *par)
 	write_reg(par, 0xC7, 0xBE);
 	/* ------------memory access control------------------------ */
 	write_reg(par, 0x3A, 0x55); /* 16bit pixel */
+	if (par->littleendian)
+		write_reg(par, 0xF6, 0x01, 0x00, 0x20); /* ENDIAN */
 	/* ------------frame rate----------------------------------- */
 	write_reg(par, 0xB1, 0x00, 0x1B);
 	/* ------------Gamma---------------------------------------- */
@@ -80,23 +82,6 @@ static int init_display(struct fbtft_par *par)
 	return 0;
 }
 
-static void set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
-{
-	fbtft_par_dbg(DEBUG_SET_ADDR_WIN, par,
-		"%s(xs=%d, ys=%d, xe=%d, ye=%d)\n", __func__, xs, ys, xe, ye);
-
-	/* Column address set */
-	write_reg(par, 0x2A,
-		(xs >> 8) & 0xFF, xs & 0xFF, (xe >> 8) & 0xFF, xe & 0xFF);
-
-	/* Row adress set */
-	write_reg(par, 0x2B,
-		(ys >> 8) & 0xFF, ys & 0xFF, (ye >> 8) & 0xFF, ye & 0xFF);
-
-	/* Memory write */
-	write_reg(par, 0x2C);
-}
-
 #define MEM_Y   (7) /* MY row address order */
 #define MEM_X   (6) /* MX column address order */
 #define MEM_V   (5) /* MV row / column exchange */
@@ -127,6 +112,19 @@ static int set_var(struct fbtft_par *par)
 	return 0;
 }
 
+/* Vertical scrolling, rows are written bottom up (MY) at 180 degrees */
+static int set_scroll(struct fbtft_par *par, unsigned yoffset)
+{
+	unsigned yres = par->info->var.yres;
+
+	if (par->info->var.rotate == 180)
+		yoffset = (yres - yoffset) % yres;
+
+	fbtft_set_scroll_dcs(par, HEIGHT, yoffset);
+
+	return 0;
+}
+
 /*
   Gamma string format:
     Positive: Par1 Par2 [...] Par15
@@ -135,17 +133,17 @@ static int set_var(struct fbtft_par *par)
 #define CURVE(num, idx)  curves[num*par->gamma.num_values + idx]
 static int set_gamma(struct fbtft_par *par, unsigned long *curves)
 {
-	int i;
+	u16 vals[1 + 15];
+	int i, j;
 
 	fbtft_par_dbg(DEBUG_INIT_DISPLAY, par, "%s()\n", __func__);
 
-	for (i = 0; i < par->gamma.num_curves; i++)
-		write_reg(par, 0xE0 + i,
-			CURVE(i, 0), CURVE(i, 1), CURVE(i, 2),
-			CURVE(i, 3), CURVE(i, 4), CURVE(i, 5),
-			CURVE(i, 6), CURVE(i, 7), CURVE(i, 8),
-			CURVE(i, 9), CURVE(i, 10), CURVE(i, 11),
-			CURVE(i, 12), CURVE(i, 13), CURVE(i, 14));
+	for (i = 0; i < par->gamma.num_curves; i++) {
+		vals[0] = 0xE0 + i;
+		for (j = 0; j < 15; j++)
+			vals[1 + j] = CURVE(i, j);
+		write_reg_buf(par, vals, ARRAY_SIZE(vals));
+	}
 
 	return 0;
 }
@@ -160,10 +158,12 @@ static struct fbtft_display display = {
 	.gamma_num = 2,
 	.gamma_len = 15,
 	.gamma = DEFAULT_GAMMA,
+	.caps = FBTFT_CAP_ADDR_WIN_X | FBTFT_CAP_TE |
+		FBTFT_CAP_LITTLE_ENDIAN | FBTFT_CAP_RAMWR_CONT,
 	.fbtftops = {
 		.init_display = init_display,
-		.set_addr_win = set_addr_win,
 		.set_var = set_var,
+		.set_scroll = set_scroll,
 		.set_gamma = set_gamma,
 	},
 };
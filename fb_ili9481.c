@@ -55,21 +55,6 @@ static int default_init_sequence[] = {
 	-3
 };
 
-static void set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
-{
-	fbtft_par_dbg(DEBUG_SET_ADDR_WIN, par,
-		"%s(xs=%d, ys=%d, xe=%d, ye=%d)\n", __func__, xs, ys, xe, ye);
-
-	/* column address */
-	write_reg(par, 0x2a, xs >> 8, xs & 0xff, xe >> 8, xe & 0xff);
-
-	/* row adress */
-	write_reg(par, 0x2b, ys >> 8, ys & 0xff, ye >> 8, ye & 0xff);
-
-	/* memory write */
-	write_reg(par, 0x2c);
-}
-
 #define HFLIP 0x01
 #define VFLIP 0x02
 #define ROWxCOL 0x20
@@ -95,14 +80,24 @@ static int set_var(struct fbtft_par *par)
 	return 0;
 }
 
+/* Vertical scrolling, the MADCTL flips also apply to the scrolling area */
+static int set_scroll(struct fbtft_par *par, unsigned yoffset)
+{
+	fbtft_set_scroll_dcs(par, HEIGHT, yoffset);
+
+	return 0;
+}
+
 static struct fbtft_display display = {
 	.regwidth = 8,
 	.width = WIDTH,
 	.height = HEIGHT,
 	.init_sequence = default_init_sequence,
+	.caps = FBTFT_CAP_ADDR_WIN_X | FBTFT_CAP_TE |
+		FBTFT_CAP_RAMWR_CONT,
 	.fbtftops = {
-		.set_addr_win = set_addr_win,
 		.set_var = set_var,
+		.set_scroll = set_scroll,
 	},
 };
 FBTFT_REGISTER_DRIVER(DRVNAME, "ilitek,ili9481", &display);
@@ -47,6 +47,7 @@ static int write_spi(struct fbtft_par *par, void *buf, size_t len)
 		.speed_hz = 1000000,
 	};
 	struct spi_message m;
+	int ret;
 
 	fbtft_par_dbg_hex(DEBUG_WRITE, par, par->info->device, u8, buf, len,
 		"%s(len=%d): ", __func__, len);
@@ -61,9 +62,14 @@ static int write_spi(struct fbtft_par *par, void *buf, size_t len)
 	if (par->txbuf.dma && buf == par->txbuf.buf) {
 		t.tx_dma = par->txbuf.dma;
 		m.is_dma_mapped = 1;
+		fbtft_txbuf_sync_for_device(par, t.tx_dma, len);
 	}
 	spi_message_add_tail(&t, &m);
-	return spi_sync(par->spi, &m);
+	ret = spi_sync(par->spi, &m);
+	if (m.is_dma_mapped)
+		fbtft_txbuf_sync_for_cpu(par, t.tx_dma, len);
+
+	return ret;
 }
 
 static int init_display(struct fbtft_par *par)
@@ -190,20 +196,26 @@ static int init_display(struct fbtft_par *par)
 	return 0;
 }
 
+static void set_active_window(struct fbtft_par *par, int xs, int ys, int xe,
+								int ye)
+{
+	write_reg(par, 0x30 , xs & 0x00FF);
+	write_reg(par, 0x31 , (xs & 0xFF00) >> 8);
+	write_reg(par, 0x32 , ys & 0x00FF);
+	write_reg(par, 0x33 , (ys & 0xFF00) >> 8);
+	write_reg(par, 0x34 , xe & 0x00FF);
+	write_reg(par, 0x35 , (xe & 0xFF00) >> 8);
+	write_reg(par, 0x36 , ye & 0x00FF);
+	write_reg(par, 0x37 , (ye & 0xFF00) >> 8);
+}
+
 static void set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
 {
 	fbtft_par_dbg(DEBUG_SET_ADDR_WIN, par,
 		"%s(xs=%d, ys=%d, xe=%d, ye=%d)\n", __func__, xs, ys, xe, ye);
 
 	/* Set_Active_Window */
-	write_reg(par, 0x30 , xs & 0x00FF);
-	write_reg(par, 0x31 , (xs & 0xFF00) >> 8);
-	write_reg(par, 0x32 , ys & 0x00FF);
-	write_reg(par, 0x33 , (ys & 0xFF00) >> 8);
-	write_reg(par, 0x34 , (xs+xe) & 0x00FF);
-	write_reg(par, 0x35 , ((xs+xe) & 0xFF00) >> 8);
-	write_reg(par, 0x36 , (ys+ye) & 0x00FF);
-	write_reg(par, 0x37 , ((ys+ye) & 0xFF00) >> 8);
+	set_active_window(par, xs, ys, xe, ye);
 
 	/* Set_Memory_Write_Cursor */
 	write_reg(par, 0x46,  xs & 0xff);
@@ -275,7 +287,6 @@ static int write_vmem16_bus8(struct fbtft_par *par, size_t offset, size_t len)
 	size_t remain;
 	size_t to_copy;
 	size_t tx_array_size;
-	int i;
 	int ret = 0;
 	size_t startbyte_size = 0;
 
@@ -295,8 +306,7 @@ static int write_vmem16_bus8(struct fbtft_par *par, size_t offset, size_t len)
 		dev_dbg(par->info->device, "    to_copy=%zu, remain=%zu\n",
 			to_copy, remain - to_copy);
 
-		for (i = 0; i < to_copy; i++)
-			txbuf16[i] = cpu_to_be16(vmem16[i]);
+		fbtft_cpu_to_be16_buf(txbuf16, vmem16, to_copy);
 
 		vmem16 = vmem16 + to_copy;
 		ret = par->fbtftops.write(par, par->txbuf.buf,
@@ -309,14 +319,153 @@ static int write_vmem16_bus8(struct fbtft_par *par, size_t offset, size_t len)
 	return ret;
 }
 
+static int read_reg(struct fbtft_par *par, u8 reg, u8 *val)
+{
+	u8 *buf = (u8 *)par->buf;
+	struct spi_transfer t = {
+		.tx_buf = buf,
+		.rx_buf = buf + 2,
+		.len = 2,
+		.speed_hz = 1000000,
+	};
+	int ret;
+
+	write_reg(par, reg);
+
+	/* data read */
+	buf[0] = 0x40;
+	buf[1] = 0x00;
+	ret = spi_sync_transfer(par->spi, &t, 1);
+	if (ret < 0)
+		return ret;
+	*val = buf[3];
+
+	return 0;
+}
+
+/* Polls reg until the busy bit clears */
+static int wait_idle(struct fbtft_par *par, u8 reg, u8 busy)
+{
+	unsigned long timeout = jiffies + msecs_to_jiffies(100);
+	u8 val;
+	int ret;
+
+	do {
+		ret = read_reg(par, reg, &val);
+		if (ret < 0)
+			return ret;
+		if (!(val & busy))
+			return 0;
+	} while (time_before(jiffies, timeout));
+
+	/* probably no MISO, don't wait for it again */
+	dev_warn(par->info->device,
+		"%s: register 0x%02X stays busy, turning off acceleration\n",
+		__func__, reg);
+	par->fbtftops.fillrect = NULL;
+	par->fbtftops.copyarea = NULL;
+
+	return -ETIMEDOUT;
+}
+
+/* Geometric drawing engine: filled square */
+static int fillrect(struct fbtft_par *par, const struct fb_fillrect *rect)
+{
+	u32 xs = rect->dx;
+	u32 ys = rect->dy;
+	u32 xe = rect->dx + rect->width - 1;
+	u32 ye = rect->dy + rect->height - 1;
+	u32 color = rect->color;
+
+	fbtft_par_dbg(DEBUG_FB_FILLRECT, par,
+		"%s(xs=%u, ys=%u, xe=%u, ye=%u, color=0x%04X)\n",
+		__func__, xs, ys, xe, ye, color);
+
+	/* drawing is clipped to the active window */
+	set_active_window(par, 0, 0, par->info->var.xres - 1,
+				par->info->var.yres - 1);
+
+	/* foreground color, 65K colors */
+	write_reg(par, 0x63, (color >> 11) & 0x1F);
+	write_reg(par, 0x64, (color >> 5) & 0x3F);
+	write_reg(par, 0x65, color & 0x1F);
+
+	/* start and end point */
+	write_reg(par, 0x91, xs & 0xFF);
+	write_reg(par, 0x92, (xs >> 8) & 0x03);
+	write_reg(par, 0x93, ys & 0xFF);
+	write_reg(par, 0x94, (ys >> 8) & 0x01);
+	write_reg(par, 0x95, xe & 0xFF);
+	write_reg(par, 0x96, (xe >> 8) & 0x03);
+	write_reg(par, 0x97, ye & 0xFF);
+	write_reg(par, 0x98, (ye >> 8) & 0x01);
+
+	/* draw filled square */
+	write_reg(par, 0x90, 0xB0);
+
+	return wait_idle(par, 0x90, 0x80);
+}
+
+/* Block Transfer Engine: move with ROP destination = source */
+static int copyarea(struct fbtft_par *par, const struct fb_copyarea *area)
+{
+	u32 sx = area->sx;
+	u32 sy = area->sy;
+	u32 dx = area->dx;
+	u32 dy = area->dy;
+	u8 op = 0x02;
+
+	fbtft_par_dbg(DEBUG_FB_COPYAREA, par,
+		"%s(sx=%u, sy=%u, dx=%u, dy=%u, width=%u, height=%u)\n",
+		__func__, sx, sy, dx, dy, area->width, area->height);
+
+	/* overlapping moves towards the end start from the bottom right */
+	if (dy > sy || (dy == sy && dx > sx)) {
+		sx += area->width - 1;
+		sy += area->height - 1;
+		dx += area->width - 1;
+		dy += area->height - 1;
+		op = 0x03;
+	}
+
+	set_active_window(par, 0, 0, par->info->var.xres - 1,
+				par->info->var.yres - 1);
+
+	/* source, layer 1 */
+	write_reg(par, 0x54, sx & 0xFF);
+	write_reg(par, 0x55, (sx >> 8) & 0x03);
+	write_reg(par, 0x56, sy & 0xFF);
+	write_reg(par, 0x57, (sy >> 8) & 0x01);
+	/* destination, layer 1 */
+	write_reg(par, 0x58, dx & 0xFF);
+	write_reg(par, 0x59, (dx >> 8) & 0x03);
+	write_reg(par, 0x5A, dy & 0xFF);
+	write_reg(par, 0x5B, (dy >> 8) & 0x01);
+	/* width and height */
+	write_reg(par, 0x5C, area->width & 0xFF);
+	write_reg(par, 0x5D, (area->width >> 8) & 0x03);
+	write_reg(par, 0x5E, area->height & 0xFF);
+	write_reg(par, 0x5F, (area->height >> 8) & 0x01);
+
+	/* ROP code S, move in positive or negative direction */
+	write_reg(par, 0x51, 0xC0 | op);
+	/* start */
+	write_reg(par, 0x50, 0x80);
+
+	return wait_idle(par, 0x50, 0x80);
+}
+
 static struct fbtft_display display = {
 	.regwidth = 8,
+	.caps = FBTFT_CAP_ADDR_WIN_X,
 	.fbtftops = {
 		.init_display = init_display,
 		.set_addr_win = set_addr_win,
 		.write_register = write_reg8_bus8,
 		.write_vmem = write_vmem16_bus8,
 		.write = write_spi,
+		.fillrect = fillrect,
+		.copyarea = copyarea,
 	},
 };
 FBTFT_REGISTER_DRIVER(DRVNAME, "raio,ra8875", &display);
@@ -100,21 +100,6 @@ static int default_init_sequence[] = {
 
 };
 
-static void set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
-{
-	fbtft_par_dbg(DEBUG_SET_ADDR_WIN, par,
-		"%s(xs=%d, ys=%d, xe=%d, ye=%d)\n", __func__, xs, ys, xe, ye);
-
-	/* Column address */
-	write_reg(par, 0x2A, xs >> 8, xs & 0xFF, xe >> 8, xe & 0xFF);
-
-	/* Row adress */
-	write_reg(par, 0x2B, ys >> 8, ys & 0xFF, ye >> 8, ye & 0xFF);
-
-	/* Memory write */
-	write_reg(par, 0x2C);
-}
-
 #define MY (1 << 7)
 #define MX (1 << 6)
 #define MV (1 << 5)
@@ -151,8 +136,8 @@ static struct fbtft_display display = {
 	.width = 128,
 	.height = 160,
 	.init_sequence = default_init_sequence,
+	.caps = FBTFT_CAP_ADDR_WIN_X,
 	.fbtftops = {
-		.set_addr_win = set_addr_win,
 		.set_var = set_var,
 	},
 };
@@ -87,6 +87,12 @@ static void set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
 	fbtft_par_dbg(DEBUG_SET_ADDR_WIN, par,
 		"%s(xs=%d, ys=%d, xe=%d, ye=%d)\n", __func__, xs, ys, xe, ye);
 
+	/* the address counter is already there */
+	if (fbtft_addr_win_continues(par, xs, ys, xe, ye)) {
+		write_reg(par, 0x22);
+		return;
+	}
+
 	switch (par->info->var.rotate) {
 	/* R4Eh - Set GDDRAM X address counter */
 	/* R4Fh - Set GDDRAM Y address counter */
@@ -110,6 +116,9 @@ static void set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
 
 	/* R22h - RAM data write */
 	write_reg(par, 0x22);
+
+	/* it runs on to the end of the display */
+	fbtft_addr_win_set(par, xs, ys, xe, par->info->var.yres - 1);
 }
 
 static int set_var(struct fbtft_par *par)
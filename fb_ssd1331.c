@@ -130,11 +130,13 @@ static void write_reg8_bus8(struct fbtft_par *par, int len, ...)
 */
 static int set_gamma(struct fbtft_par *par, unsigned long *curves)
 {
-	unsigned long tmp[GAMMA_NUM * GAMMA_LEN];
+	u16 tmp[1 + GAMMA_NUM * GAMMA_LEN];
 	int i, acc = 0;
 
 	fbtft_par_dbg(DEBUG_INIT_DISPLAY, par, "%s()\n", __func__);
 
+	tmp[0] = 0xB8;
+
 	for (i = 0; i < 63; i++) {
 		if (i > 0 && curves[i] < 2) {
 			dev_err(par->info->device,
@@ -143,7 +145,7 @@ static int set_gamma(struct fbtft_par *par, unsigned long *curves)
 			return -EINVAL;
 		}
 		acc += curves[i];
-		tmp[i] = acc;
+		tmp[1 + i] = acc;
 		if (acc > 180) {
 			dev_err(par->info->device,
 				"Illegal value(s) in Grayscale Lookup Table. " \
@@ -152,15 +154,61 @@ static int set_gamma(struct fbtft_par *par, unsigned long *curves)
 		}
 	}
 
-	write_reg(par, 0xB8,
-	tmp[0], tmp[1], tmp[2], tmp[3], tmp[4], tmp[5], tmp[6], tmp[7],
-	tmp[8], tmp[9], tmp[10], tmp[11], tmp[12], tmp[13], tmp[14], tmp[15],
-	tmp[16], tmp[17], tmp[18], tmp[19], tmp[20], tmp[21], tmp[22], tmp[23],
-	tmp[24], tmp[25], tmp[26], tmp[27], tmp[28], tmp[29], tmp[30], tmp[31],
-	tmp[32], tmp[33], tmp[34], tmp[35], tmp[36], tmp[37], tmp[38], tmp[39],
-	tmp[40], tmp[41], tmp[42], tmp[43], tmp[44], tmp[45], tmp[46], tmp[47],
-	tmp[48], tmp[49], tmp[50], tmp[51], tmp[52], tmp[53], tmp[54], tmp[55],
-	tmp[56], tmp[57], tmp[58], tmp[59], tmp[60], tmp[61], tmp[62]);
+	write_reg_buf(par, tmp, ARRAY_SIZE(tmp));
+
+	return 0;
+}
+
+/* Graphic acceleration commands take colours as C, B, A */
+#define COLOR_CBA(par, color) \
+	((par)->bgr ? ((color) << 1) & 0x3f : ((color) >> 11) << 1), \
+	((color) >> 5) & 0x3f, \
+	((par)->bgr ? ((color) >> 11) << 1 : ((color) << 1) & 0x3f)
+
+static int fillrect(struct fbtft_par *par, const struct fb_fillrect *rect)
+{
+	u32 xs = rect->dx;
+	u32 ys = rect->dy;
+	u32 xe = rect->dx + rect->width - 1;
+	u32 ye = rect->dy + rect->height - 1;
+	u32 color = rect->color;
+
+	fbtft_par_dbg(DEBUG_FB_FILLRECT, par,
+		"%s(xs=%u, ys=%u, xe=%u, ye=%u, color=0x%04X)\n",
+		__func__, xs, ys, xe, ye, color);
+
+	if (color == 0) {
+		write_reg(par, 0x25, xs, ys, xe, ye); /* Clear Window */
+	} else {
+		write_reg(par, 0x26, 0x01); /* Fill Enable */
+		write_reg(par, 0x22, xs, ys, xe, ye, /* Draw Rectangle */
+			COLOR_CBA(par, color), COLOR_CBA(par, color));
+	}
+
+	/* the controller can't be polled, wait for it to finish */
+	usleep_range(3000, 4000);
+
+	return 0;
+}
+
+static int copyarea(struct fbtft_par *par, const struct fb_copyarea *area)
+{
+	u32 sx = area->sx, sy = area->sy;
+	u32 dx = area->dx, dy = area->dy;
+	u32 w = area->width, h = area->height;
+
+	fbtft_par_dbg(DEBUG_FB_COPYAREA, par,
+		"%s(sx=%u, sy=%u, dx=%u, dy=%u, width=%u, height=%u)\n",
+		__func__, sx, sy, dx, dy, w, h);
+
+	/* copies in raster order, so overlapping moves down or right break */
+	if (dx < sx + w && sx < dx + w && dy < sy + h && sy < dy + h &&
+	    (dy > sy || (dy == sy && dx > sx)))
+		return -EINVAL;
+
+	write_reg(par, 0x23, sx, sy, sx + w - 1, sy + h - 1, dx, dy); /* Copy */
+
+	usleep_range(3000, 4000);
 
 	return 0;
 }
@@ -184,12 +232,15 @@ static struct fbtft_display display = {
 	.gamma_num = GAMMA_NUM,
 	.gamma_len = GAMMA_LEN,
 	.gamma = DEFAULT_GAMMA,
+	.caps = FBTFT_CAP_ADDR_WIN_X,
 	.fbtftops = {
 		.write_register = write_reg8_bus8,
 		.init_display = init_display,
 		.set_addr_win = set_addr_win,
 		.set_gamma = set_gamma,
 		.blank = blank,
+		.fillrect = fillrect,
+		.copyarea = copyarea,
 	},
 };
 
@@ -126,11 +126,13 @@ static int set_var(struct fbtft_par *par)
 */
 static int set_gamma(struct fbtft_par *par, unsigned long *curves)
 {
-	unsigned long tmp[GAMMA_NUM * GAMMA_LEN];
+	u16 tmp[1 + GAMMA_NUM * GAMMA_LEN];
 	int i, acc = 0;
 
 	fbtft_par_dbg(DEBUG_INIT_DISPLAY, par, "%s()\n", __func__);
 
+	tmp[0] = 0xB8;
+
 	for (i = 0; i < 63; i++) {
 		if (i > 0 && curves[i] < 2) {
 			dev_err(par->info->device,
@@ -139,7 +141,7 @@ static int set_gamma(struct fbtft_par *par, unsigned long *curves)
 			return -EINVAL;
 		}
 		acc += curves[i];
-		tmp[i] = acc;
+		tmp[1 + i] = acc;
 		if (acc > 180) {
 			dev_err(par->info->device,
 				"Illegal value(s) in Grayscale Lookup Table. " \
@@ -148,15 +150,7 @@ static int set_gamma(struct fbtft_par *par, unsigned long *curves)
 		}
 	}
 
-	write_reg(par, 0xB8,
-	tmp[0], tmp[1], tmp[2], tmp[3], tmp[4], tmp[5], tmp[6], tmp[7],
-	tmp[8], tmp[9], tmp[10], tmp[11], tmp[12], tmp[13], tmp[14], tmp[15],
-	tmp[16], tmp[17], tmp[18], tmp[19], tmp[20], tmp[21], tmp[22], tmp[23],
-	tmp[24], tmp[25], tmp[26], tmp[27], tmp[28], tmp[29], tmp[30], tmp[31],
-	tmp[32], tmp[33], tmp[34], tmp[35], tmp[36], tmp[37], tmp[38], tmp[39],
-	tmp[40], tmp[41], tmp[42], tmp[43], tmp[44], tmp[45], tmp[46], tmp[47],
-	tmp[48], tmp[49], tmp[50], tmp[51], tmp[52], tmp[53], tmp[54], tmp[55],
-	tmp[56], tmp[57], tmp[58], tmp[59], tmp[60], tmp[61], tmp[62]);
+	write_reg_buf(par, tmp, ARRAY_SIZE(tmp));
 
 	return 0;
 }
@@ -180,6 +174,7 @@ static struct fbtft_display display = {
 	.gamma_num = GAMMA_NUM,
 	.gamma_len = GAMMA_LEN,
 	.gamma = DEFAULT_GAMMA,
+	.caps = FBTFT_CAP_ADDR_WIN_X,
 	.fbtftops = {
 		.init_display = init_display,
 		.set_addr_win = set_addr_win,
@@ -94,21 +94,6 @@ static int default_init_sequence[] = {
 	-3                                  
 };
 
-static void set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
-{
-	fbtft_par_dbg(DEBUG_SET_ADDR_WIN, par,
-		"%s(xs=%d, ys=%d, xe=%d, ye=%d)\n", __func__, xs, ys, xe, ye);
-
-	/* Column address */
-	write_reg(par, 0x2A, xs >> 8, xs & 0xFF, xe >> 8, xe & 0xFF);
-
-	/* Row adress */
-	write_reg(par, 0x2B, ys >> 8, ys & 0xFF, ye >> 8, ye & 0xFF);
-
-	/* Memory write */
-	write_reg(par, 0x2C);
-}
-
 #define MY (1 << 7)
 #define MX (1 << 6)
 #define MV (1 << 5)
@@ -140,6 +125,19 @@ static int set_var(struct fbtft_par *par)
 	return 0;
 }
 
+/* Vertical scrolling, rows are written bottom up (MY) when not rotated */
+static int set_scroll(struct fbtft_par *par, unsigned yoffset)
+{
+	unsigned yres = par->info->var.yres;
+
+	if (par->info->var.rotate == 0)
+		yoffset = (yres - yoffset) % yres;
+
+	fbtft_set_scroll_dcs(par, 160, yoffset);
+
+	return 0;
+}
+
 /*
   Gamma string format:
     VRF0P VOS0P PK0P PK1P PK2P PK3P PK4P PK5P PK6P PK7P PK8P PK9P SELV0P SELV1P SELV62P SELV63P
@@ -148,6 +146,7 @@ static int set_var(struct fbtft_par *par)
 #define CURVE(num, idx)  curves[num*par->gamma.num_values + idx]
 static int set_gamma(struct fbtft_par *par, unsigned long *curves)
 {
+	u16 vals[1 + 16];
 	int i,j;
 
 	fbtft_par_dbg(DEBUG_INIT_DISPLAY, par, "%s()\n", __func__);
@@ -157,12 +156,12 @@ static int set_gamma(struct fbtft_par *par, unsigned long *curves)
 		for (j = 0; j < par->gamma.num_values; j++)
 			CURVE(i,j) &= 0b111111;
 
-	for (i = 0; i < par->gamma.num_curves; i++)
-		write_reg(par, 0xE0 + i,
-			CURVE(i, 0), CURVE(i, 1), CURVE(i, 2), CURVE(i, 3),
-			CURVE(i, 4), CURVE(i, 5), CURVE(i, 6), CURVE(i, 7),
-			CURVE(i, 8), CURVE(i, 9), CURVE(i, 10), CURVE(i, 11),
-			CURVE(i, 12), CURVE(i, 13), CURVE(i, 14), CURVE(i,15));
+	for (i = 0; i < par->gamma.num_curves; i++) {
+		vals[0] = 0xE0 + i;
+		for (j = 0; j < 16; j++)
+			vals[1 + j] = CURVE(i, j);
+		write_reg_buf(par, vals, ARRAY_SIZE(vals));
+	}
 
 	return 0;
 }
@@ -177,9 +176,10 @@ static struct fbtft_display display = {
 	.gamma_num = 2,
 	.gamma_len = 16,
 	.gamma = DEFAULT_GAMMA,
+	.caps = FBTFT_CAP_ADDR_WIN_X | FBTFT_CAP_TE,
 	.fbtftops = {
-		.set_addr_win = set_addr_win,
 		.set_var = set_var,
+		.set_scroll = set_scroll,
 		.set_gamma = set_gamma,
 	},
 };
@@ -108,6 +108,7 @@ static struct fbtft_display display = {
 	.regwidth = 8,
 	.width = WIDTH,
 	.height = HEIGHT,
+	.caps = FBTFT_CAP_ADDR_WIN_X,
 	.fbtftops = {
 		.init_display = init_display,
 		.set_addr_win = set_addr_win,
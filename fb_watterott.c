@@ -76,12 +76,14 @@ static int write_vmem(struct fbtft_par *par, size_t offset, size_t len)
 	u16 *vmem16 = (u16 *)(par->info->screen_base + offset);
 	u16 *pos = par->txbuf.buf + 1;
 	u16 *buf16 = par->txbuf.buf + 10;
-	int i, j;
+	int i;
 	int ret = 0;
 
 	fbtft_par_dbg(DEBUG_WRITE_VMEM, par, "%s()\n", __func__);
 
-	start_line = offset / par->info->fix.line_length;
+	/* offset includes the front buffer, the panel has one frame */
+	start_line = (offset - par->update.offset) /
+			par->info->fix.line_length;
 	end_line = start_line + (len / par->info->fix.line_length) - 1;
 
 	/* Set command header. pos: x, y, w, h */
@@ -93,8 +95,8 @@ static int write_vmem(struct fbtft_par *par, size_t offset, size_t len)
 
 	for (i = start_line; i <= end_line; i++) {
 		pos[1] = cpu_to_be16(i);
-		for (j = 0; j < par->info->var.xres; j++)
-			buf16[j] = cpu_to_be16(*vmem16++);
+		fbtft_cpu_to_be16_buf(buf16, vmem16, par->info->var.xres);
+		vmem16 += par->info->var.xres;
 		ret = par->fbtftops.write(par,
 			par->txbuf.buf, 10 + par->info->fix.line_length);
 		if (ret < 0)
@@ -120,7 +122,9 @@ static int write_vmem_8bit(struct fbtft_par *par, size_t offset, size_t len)
 
 	fbtft_par_dbg(DEBUG_WRITE_VMEM, par, "%s()\n", __func__);
 
-	start_line = offset / par->info->fix.line_length;
+	/* offset includes the front buffer, the panel has one frame */
+	start_line = (offset - par->update.offset) /
+			par->info->fix.line_length;
 	end_line = start_line + (len / par->info->fix.line_length) - 1;
 
 	/* Set command header. pos: x, y, w, h */
@@ -1,7 +1,20 @@
 #include <linux/export.h>
 #include <linux/errno.h>
+#include <linux/string.h>
 #include <linux/gpio.h>
 #include <linux/spi/spi.h>
+#include <linux/bitops.h>
+#include <linux/swab.h>
+#include <linux/hardirq.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/vmalloc.h>
+#include <linux/slab.h>
+#include <linux/dma-mapping.h>
+#include <asm/unaligned.h>
+#ifdef CONFIG_KERNEL_MODE_NEON
+#include <asm/neon.h>
+#endif
 #include "fbtft.h"
 
 
@@ -9,28 +22,26 @@
 
 /*****************************************************************************
  *
- *   void (*write_reg)(struct fbtft_par *par, int len, ...);
+ *   void (*write_register_buf)(struct fbtft_par *par, const u16 *vals,
+ *                              int len);
  *
  *****************************************************************************/
 
-#define define_fbtft_write_reg(func, type, modifier)                          \
-void func(struct fbtft_par *par, int len, ...)                                \
+#define define_fbtft_write_reg_buf(func, type, modifier)                      \
+void func(struct fbtft_par *par, const u16 *vals, int len)                    \
 {                                                                             \
-	va_list args;                                                         \
 	int i, ret;                                                           \
 	int offset = 0;                                                       \
 	type *buf = (type *)par->buf;                                         \
 									      \
 	if (unlikely(par->debug & DEBUG_WRITE_REGISTER)) {                    \
-		va_start(args, len);                                          \
 		for (i = 0; i < len; i++) {                                   \
-			buf[i] = (type)va_arg(args, unsigned int);            \
+			buf[i] = (type)vals[i];                               \
 		}                                                             \
-		va_end(args);                                                 \
 		fbtft_par_dbg_hex(DEBUG_WRITE_REGISTER, par, par->info->device, type, buf, len, "%s: ", __func__);   \
 	}                                                                     \
-									      \
-	va_start(args, len);                                                  \
+	if (len <= 0)                                                         \
+		return;                                                       \
 									      \
 	if (par->startbyte) {                                                 \
 		*(u8 *)par->buf = par->startbyte;                             \
@@ -38,12 +49,21 @@ void func(struct fbtft_par *par, int len, ...)                                \
 		offset = 1;                                                   \
 	}                                                                     \
 									      \
-	*buf = modifier((type)va_arg(args, unsigned int));                    \
+	*buf = modifier((type)vals[0]);                                       \
+	if (par->cmdq.open) {                                                 \
+		fbtft_cmdq_add(par, false, buf, sizeof(type));                \
+		for (i = 1; i < len; i++)                                     \
+			buf[i] = modifier((type)vals[i]);                     \
+		if (len > 1)                                                  \
+			fbtft_cmdq_add(par, true, buf + 1,                    \
+					(len - 1) * sizeof(type));            \
+		return;                                                       \
+	}                                                                     \
+									      \
 	if (par->gpio.dc != -1)                                               \
 		gpio_set_value(par->gpio.dc, 0);                              \
 	ret = par->fbtftops.write(par, par->buf, sizeof(type)+offset);        \
 	if (ret < 0) {                                                        \
-		va_end(args);                                                 \
 		dev_err(par->info->device, "%s: write() failed and returned %d\n", __func__, ret); \
 		return;                                                       \
 	}                                                                     \
@@ -53,39 +73,32 @@ void func(struct fbtft_par *par, int len, ...)                                \
 		*(u8 *)par->buf = par->startbyte | 0x2;                       \
 									      \
 	if (len) {                                                            \
-		i = len;                                                      \
-		while (i--) {                                                 \
-			*buf++ = modifier((type)va_arg(args, unsigned int));  \
-		}                                                             \
+		for (i = 0; i < len; i++)                                     \
+			buf[i] = modifier((type)vals[i + 1]);                 \
 		if (par->gpio.dc != -1)                                       \
 			gpio_set_value(par->gpio.dc, 1);                      \
 		ret = par->fbtftops.write(par, par->buf, len * (sizeof(type)+offset)); \
 		if (ret < 0) {                                                \
-			va_end(args);                                         \
 			dev_err(par->info->device, "%s: write() failed and returned %d\n", __func__, ret); \
 			return;                                               \
 		}                                                             \
 	}                                                                     \
-	va_end(args);                                                         \
 }                                                                             \
 EXPORT_SYMBOL(func);
 
-define_fbtft_write_reg(fbtft_write_reg8_bus8, u8, )
-define_fbtft_write_reg(fbtft_write_reg16_bus8, u16, cpu_to_be16)
-define_fbtft_write_reg(fbtft_write_reg16_bus16, u16, )
+define_fbtft_write_reg_buf(fbtft_write_reg8_bus8_buf, u8, )
+define_fbtft_write_reg_buf(fbtft_write_reg16_bus8_buf, u16, cpu_to_be16)
+define_fbtft_write_reg_buf(fbtft_write_reg16_bus16_buf, u16, )
 
-void fbtft_write_reg8_bus9(struct fbtft_par *par, int len, ...)
+void fbtft_write_reg8_bus9_buf(struct fbtft_par *par, const u16 *vals, int len)
 {
-	va_list args;
 	int i, ret;
 	int pad = 0;
 	u16 *buf = (u16 *)par->buf;
 
 	if (unlikely(par->debug & DEBUG_WRITE_REGISTER)) {
-		va_start(args, len);
 		for (i = 0; i < len; i++)
-			*(((u8 *)buf) + i) = (u8)va_arg(args, unsigned int);
-		va_end(args);
+			*(((u8 *)buf) + i) = (u8)vals[i];
 		fbtft_par_dbg_hex(DEBUG_WRITE_REGISTER, par,
 			par->info->device, u8, buf, len, "%s: ", __func__);
 	}
@@ -100,14 +113,9 @@ void fbtft_write_reg8_bus9(struct fbtft_par *par, int len, ...)
 			*buf++ = 0x000;
 	}
 
-	va_start(args, len);
-	*buf++ = (u8)va_arg(args, unsigned int);
-	i = len - 1;
-	while (i--) {
-		*buf = (u8)va_arg(args, unsigned int);
-		*buf++ |= 0x100; /* dc=1 */
-	}
-	va_end(args);
+	*buf++ = (u8)vals[0];
+	for (i = 1; i < len; i++)
+		*buf++ = (u8)vals[i] | 0x100; /* dc=1 */
 	ret = par->fbtftops.write(par, par->buf, (len + pad) * sizeof(u16));
 	if (ret < 0) {
 		dev_err(par->info->device,
@@ -115,8 +123,541 @@ void fbtft_write_reg8_bus9(struct fbtft_par *par, int len, ...)
 		return;
 	}
 }
-EXPORT_SYMBOL(fbtft_write_reg8_bus9);
+EXPORT_SYMBOL(fbtft_write_reg8_bus9_buf);
+
+
+
+/*****************************************************************************
+ *
+ *   void (*write_reg)(struct fbtft_par *par, int len, ...);
+ *
+ *****************************************************************************/
+
+#define define_fbtft_write_reg(func, buf_func)                                \
+void func(struct fbtft_par *par, int len, ...)                                \
+{                                                                             \
+	u16 vals[FBTFT_MAX_REG_VALUES];                                       \
+	va_list args;                                                         \
+	int i;                                                                \
+									      \
+	if (len > FBTFT_MAX_REG_VALUES) {                                     \
+		dev_err(par->info->device, "%s: Maximum register values exceeded\n", __func__); \
+		return;                                                       \
+	}                                                                     \
+									      \
+	va_start(args, len);                                                  \
+	for (i = 0; i < len; i++)                                             \
+		vals[i] = (u16)va_arg(args, unsigned int);                    \
+	va_end(args);                                                         \
+									      \
+	buf_func(par, vals, len);                                             \
+}                                                                             \
+EXPORT_SYMBOL(func);
+
+define_fbtft_write_reg(fbtft_write_reg8_bus8, fbtft_write_reg8_bus8_buf)
+define_fbtft_write_reg(fbtft_write_reg16_bus8, fbtft_write_reg16_bus8_buf)
+define_fbtft_write_reg(fbtft_write_reg16_bus16, fbtft_write_reg16_bus16_buf)
+define_fbtft_write_reg(fbtft_write_reg8_bus9, fbtft_write_reg8_bus9_buf)
+
+
+
+
+/*****************************************************************************
+ *
+ *   Command queue
+ *
+ *   Experimental, off by default (cmdq module parameter).
+ *
+ *   set_addr_win() and init sequences can queue their register writes.
+ *   Contiguous bytes with the same Data/Command level are merged into one
+ *   segment, and each run of such segments is sent as one SPI message.
+ *   This doesn't reduce the number of messages much: every command byte
+ *   still flips DC, so a column/row/memory write window is 5 messages.
+ *   What is saved is the waiting, the next message is started from the
+ *   completion of the previous one, so the caller only waits once.
+ *
+ *****************************************************************************/
+
+/**
+ * fbtft_cmdq_init() - Check if the display can use the command queue
+ * @par: Driver data
+ *
+ * Needs plain 8-bit SPI, the default 8-bit bus register writes and a DC
+ * GPIO that can be set from the SPI completion. Pixels sent as 16-bit
+ * words get their own word size, but chained transmit buffers are not
+ * queued.
+ */
+void fbtft_cmdq_init(struct fbtft_par *par)
+{
+	struct fbtft_cmdq *q = &par->cmdq;
+
+	init_completion(&q->done);
+	q->enabled = par->spi && !par->startbyte && !par->chain.num &&
+		     par->fbtftops.write == fbtft_write_spi &&
+		     (par->fbtftops.write_register == fbtft_write_reg8_bus8 ||
+		      par->fbtftops.write_register == fbtft_write_reg16_bus8) &&
+		     (par->fbtftops.write_register_buf ==
+					fbtft_write_reg8_bus8_buf ||
+		      par->fbtftops.write_register_buf ==
+					fbtft_write_reg16_bus8_buf) &&
+		     (par->gpio.dc == -1 || !gpio_cansleep(par->gpio.dc));
+}
+EXPORT_SYMBOL(fbtft_cmdq_init);
+
+/**
+ * fbtft_cmdq_open() - Queue register writes until fbtft_cmdq_submit()
+ * @par: Driver data
+ *
+ * Return: true if register writes are queued
+ */
+bool fbtft_cmdq_open(struct fbtft_par *par)
+{
+	par->cmdq.open = par->cmdq.enabled;
+
+	return par->cmdq.open;
+}
+EXPORT_SYMBOL(fbtft_cmdq_open);
+
+/* Sends a full queue, the error is returned by fbtft_cmdq_submit() */
+static void fbtft_cmdq_make_room(struct fbtft_par *par)
+{
+	int ret = fbtft_cmdq_flush(par);
+
+	if (ret < 0 && !par->cmdq.error)
+		par->cmdq.error = ret;
+}
+
+/**
+ * fbtft_cmdq_add() - Queue a copy of some bytes
+ * @par: Driver data
+ * @dc: Level of the Data/Command signal
+ * @buf: Bytes to send
+ * @len: Number of bytes, at most FBTFT_CMDQ_BYTES
+ *
+ * Bytes with the same @dc level as the previous ones are merged into its
+ * segment.
+ */
+void fbtft_cmdq_add(struct fbtft_par *par, bool dc, const void *buf,
+								size_t len)
+{
+	struct fbtft_cmdq *q = &par->cmdq;
+	struct fbtft_cmdq_seg *last = q->num ? &q->seg[q->num - 1] : NULL;
+
+	if (q->used + len > FBTFT_CMDQ_BYTES) {
+		fbtft_cmdq_make_room(par);
+		last = NULL;
+	}
+
+	if (last && last->dc == dc &&
+	    last->buf + last->len == q->data + q->used) {
+		last->len += len;
+	} else {
+		if (q->num == FBTFT_CMDQ_SEGS)
+			fbtft_cmdq_make_room(par);
+		q->seg[q->num].buf = q->data + q->used;
+		q->seg[q->num].len = len;
+		q->seg[q->num].dma = 0;
+		q->seg[q->num].bpw = 0;
+		q->seg[q->num].dc = dc;
+		q->num++;
+	}
+	memcpy(q->data + q->used, buf, len);
+	q->used += len;
+}
+EXPORT_SYMBOL(fbtft_cmdq_add);
+
+/**
+ * fbtft_cmdq_add_ref() - Queue a buffer without copying it
+ * @par: Driver data
+ * @dc: Level of the Data/Command signal
+ * @buf: Bytes to send, must not change until the queue is sent
+ * @len: Number of bytes
+ * @dma: DMA address of @buf, 0 if not DMA mapped
+ * @bpw: SPI word size, 0 for the device's
+ */
+void fbtft_cmdq_add_ref(struct fbtft_par *par, bool dc, const void *buf,
+					size_t len, dma_addr_t dma, u8 bpw)
+{
+	struct fbtft_cmdq *q = &par->cmdq;
+
+	if (q->num == FBTFT_CMDQ_SEGS)
+		fbtft_cmdq_make_room(par);
+	q->seg[q->num].buf = buf;
+	q->seg[q->num].len = len;
+	q->seg[q->num].dma = dma;
+	q->seg[q->num].bpw = bpw;
+	q->seg[q->num].dc = dc;
+	q->num++;
+}
+EXPORT_SYMBOL(fbtft_cmdq_add_ref);
+
+static void fbtft_cmdq_complete(void *context);
+
+/* Start the next run of segments with the same DC level */
+static int fbtft_cmdq_send_run(struct fbtft_par *par)
+{
+	struct fbtft_cmdq *q = &par->cmdq;
+	struct spi_message *m = &q->msg[q->cur];
+	struct fbtft_cmdq_seg *seg;
+	struct spi_transfer *t;
+	bool dc = q->seg[q->next].dc;
+	bool mapped = true;
+	unsigned i;
+
+	spi_message_init(m);
+	for (i = q->next; i < q->num && q->seg[i].dc == dc; i++) {
+		seg = &q->seg[i];
+		t = &q->xfer[i];
+		memset(t, 0, sizeof(*t));
+		t->tx_buf = seg->buf;
+		t->tx_dma = seg->dma;
+		t->len = seg->len;
+		t->bits_per_word = seg->bpw;
+		if (!seg->dma)
+			mapped = false;
+		spi_message_add_tail(t, m);
+	}
+	/* all or nothing */
+	m->is_dma_mapped = mapped;
+	if (mapped)
+		for (i = q->next; i < q->num && q->seg[i].dc == dc; i++)
+			fbtft_txbuf_sync_for_device(par, q->seg[i].dma,
+							q->seg[i].len);
+	m->complete = fbtft_cmdq_complete;
+	m->context = par;
+	q->next = i;
+	q->cur ^= 1;
+
+	if (par->gpio.dc != -1)
+		gpio_set_value(par->gpio.dc, dc);
+
+	return spi_async(par->spi, m);
+}
+
+static void fbtft_cmdq_complete(void *context)
+{
+	struct fbtft_par *par = context;
+	struct fbtft_cmdq *q = &par->cmdq;
+	struct spi_message *m = &q->msg[q->cur ^ 1];
+	int ret = m->status;
+
+	if (!ret && q->next < q->num) {
+		ret = fbtft_cmdq_send_run(par);
+		if (!ret)
+			return;
+	}
+
+	q->status = ret;
+	complete(&q->done);
+}
+
+/**
+ * fbtft_cmdq_flush() - Send the queued segments
+ * @par: Driver data
+ *
+ * The queue stays open.
+ *
+ * Return: 0 if successful, negative if error
+ */
+int fbtft_cmdq_flush(struct fbtft_par *par)
+{
+	struct fbtft_cmdq *q = &par->cmdq;
+	unsigned i;
+	int ret;
+
+	if (!q->num)
+		return 0;
+
+	fbtft_par_dbg(DEBUG_WRITE, par, "%s: %u segments\n", __func__,
+								q->num);
+
+	init_completion(&q->done);
+	q->next = 0;
+	q->status = 0;
+	ret = fbtft_cmdq_send_run(par);
+	if (!ret) {
+		wait_for_completion(&q->done);
+		ret = q->status;
+	}
+
+	for (i = 0; i < q->num; i++)
+		fbtft_txbuf_sync_for_cpu(par, q->seg[i].dma, q->seg[i].len);
+	q->num = 0;
+	q->used = 0;
+
+	if (ret < 0)
+		dev_err(par->info->device,
+			"%s: failed and returned %d\n", __func__, ret);
+
+	return ret;
+}
+EXPORT_SYMBOL(fbtft_cmdq_flush);
+
+/**
+ * fbtft_cmdq_submit() - Send the queue and close it
+ * @par: Driver data
+ *
+ * Register writes are done right away again.
+ *
+ * Return: 0 if successful, negative if this or an earlier flush of the
+ * queue failed
+ */
+int fbtft_cmdq_submit(struct fbtft_par *par)
+{
+	struct fbtft_cmdq *q = &par->cmdq;
+	int ret;
+
+	q->open = false;
+	ret = fbtft_cmdq_flush(par);
+	if (!ret)
+		ret = q->error;
+	q->error = 0;
+
+	return ret;
+}
+EXPORT_SYMBOL(fbtft_cmdq_submit);
+
+
+
+/*****************************************************************************
+ *
+ *   RGB565 conversion
+ *
+ *****************************************************************************/
+
+#define FBTFT_PIX_PER_LONG	(sizeof(unsigned long) / 2)
+
+/* below this many pixels, saving the NEON state costs more than it gains */
+#define FBTFT_NEON_MIN		256
+
+#ifdef CONFIG_KERNEL_MODE_NEON
+static bool fbtft_neon_usable(size_t n)
+{
+	if (n < FBTFT_NEON_MIN || in_interrupt())
+		return false;
+#ifdef CONFIG_ARM
+	return cpu_has_neon();
+#else
+	return true;
+#endif
+}
+#else
+static inline bool fbtft_neon_usable(size_t n)
+{
+	return false;
+}
+#endif
+
+/* byteswap each of the pixels in a long */
+static inline unsigned long fbtft_swab16_long(unsigned long x)
+{
+#if BITS_PER_LONG == 64
+	return ((x & 0x00ff00ff00ff00ffUL) << 8) |
+	       ((x >> 8) & 0x00ff00ff00ff00ffUL);
+#else
+	return ror32(swab32(x), 16);
+#endif
+}
+
+/* a long at a time, with aligned loads */
+static void fbtft_swab16_words(u16 *dst, const u16 *src, size_t n)
+{
+	for (; n && !IS_ALIGNED((unsigned long)src, sizeof(long)); n--)
+		*dst++ = swab16(*src++);
+
+	/* the startbyte leaves dst unaligned */
+	if (IS_ENABLED(CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS) ||
+	    IS_ALIGNED((unsigned long)dst, sizeof(long))) {
+		for (; n >= FBTFT_PIX_PER_LONG; n -= FBTFT_PIX_PER_LONG) {
+			put_unaligned(fbtft_swab16_long(
+					*(const unsigned long *)src),
+				      (unsigned long *)dst);
+			src += FBTFT_PIX_PER_LONG;
+			dst += FBTFT_PIX_PER_LONG;
+		}
+	}
+
+	for (; n; n--)
+		*dst++ = swab16(*src++);
+}
+
+/**
+ * fbtft_cpu_to_be16_buf() - Convert RGB565 pixels to bus byte order
+ * @dst: Destination, may be unaligned
+ * @src: Source pixels
+ * @n: Number of pixels
+ */
+void fbtft_cpu_to_be16_buf(u16 *dst, const u16 *src, size_t n)
+{
+#ifdef __BIG_ENDIAN
+	memcpy(dst, src, n * 2);
+#else
+#ifdef CONFIG_KERNEL_MODE_NEON
+	size_t m;
+
+	if (fbtft_neon_usable(n)) {
+		m = n & ~15;
+		kernel_neon_begin();
+		fbtft_swab16_neon(dst, src, m);
+		kernel_neon_end();
+		dst += m;
+		src += m;
+		n -= m;
+	}
+#endif
+	fbtft_swab16_words(dst, src, n);
+#endif
+}
+EXPORT_SYMBOL(fbtft_cpu_to_be16_buf);
+
+/**
+ * fbtft_cpu_to_bus9_buf() - Expand RGB565 pixels to 9-bit SPI words
+ * @dst: Destination, 2 words per pixel: dc + high byte, dc + low byte
+ * @src: Source pixels
+ * @n: Number of pixels
+ */
+void fbtft_cpu_to_bus9_buf(u16 *dst, const u16 *src, size_t n)
+{
+	u32 p;
+
+#if defined(CONFIG_KERNEL_MODE_NEON) && defined(__LITTLE_ENDIAN)
+	size_t m;
+
+	if (fbtft_neon_usable(n)) {
+		m = n & ~7;
+		kernel_neon_begin();
+		fbtft_bus9_neon(dst, src, m);
+		kernel_neon_end();
+		dst += 2 * m;
+		src += m;
+		n -= m;
+	}
+#endif
+	/* one store per pixel */
+	for (; n; n--) {
+		p = *src++;
+#ifdef __LITTLE_ENDIAN
+		put_unaligned(0x01000100 | (p >> 8) | (p & 0xff) << 16,
+							(u32 *)dst);
+#else
+		put_unaligned(0x01000100 | (p >> 8) << 16 | (p & 0xff),
+							(u32 *)dst);
+#endif
+		dst += 2;
+	}
+}
+EXPORT_SYMBOL(fbtft_cpu_to_bus9_buf);
+
+#define FBTFT_BENCH_RUNS	8
+#define FBTFT_BENCH_TXBUF	(4 * PAGE_SIZE)
+
+static u64 fbtft_ps_per_pixel(s64 ns, size_t n)
+{
+	return div_u64(ns * 1000, n);
+}
+
+/*
+ * Byteswap into an uncached coherent buffer and into a cached buffer
+ * that is synced for streaming DMA, the two kinds of transmit buffer.
+ */
+static void fbtft_benchmark_txbuf(struct fbtft_par *par, size_t n)
+{
+	struct device *dev = par->info->device;
+	const u16 *src = (const u16 *)par->info->screen_base;
+	s64 coherent = S64_MAX, cached = S64_MAX;
+	size_t len = min_t(size_t, FBTFT_BENCH_TXBUF, n * 2);
+	dma_addr_t coherent_dma, cached_dma;
+	u16 *coherent_buf, *cached_buf;
+	ktime_t start;
+	int i;
+
+	if (!par->txbuf.dma) {
+		dev_info(dev, "transmit buffer benchmark needs DMA\n");
+		return;
+	}
+
+	coherent_buf = dma_alloc_coherent(dev, len, &coherent_dma, GFP_KERNEL);
+	cached_buf = kmalloc(len, GFP_KERNEL | GFP_DMA);
+	if (!coherent_buf || !cached_buf)
+		goto out;
+	cached_dma = dma_map_single(dev, cached_buf, len, DMA_TO_DEVICE);
+	if (dma_mapping_error(dev, cached_dma))
+		goto out;
+
+	for (i = 0; i < FBTFT_BENCH_RUNS; i++) {
+		start = ktime_get();
+		fbtft_cpu_to_be16_buf(coherent_buf, src, len / 2);
+		coherent = min(coherent,
+			       ktime_to_ns(ktime_sub(ktime_get(), start)));
+
+		start = ktime_get();
+		dma_sync_single_for_cpu(dev, cached_dma, len, DMA_TO_DEVICE);
+		fbtft_cpu_to_be16_buf(cached_buf, src, len / 2);
+		dma_sync_single_for_device(dev, cached_dma, len,
+							DMA_TO_DEVICE);
+		cached = min(cached, ktime_to_ns(ktime_sub(ktime_get(), start)));
+	}
+	dma_unmap_single(dev, cached_dma, len, DMA_TO_DEVICE);
+
+	dev_info(dev,
+		"transmit buffer byteswap, ps/pixel: coherent %llu, streaming %llu\n",
+		fbtft_ps_per_pixel(coherent, len / 2),
+		fbtft_ps_per_pixel(cached, len / 2));
+out:
+	kfree(cached_buf);
+	if (coherent_buf)
+		dma_free_coherent(dev, len, coherent_buf, coherent_dma);
+}
+
+/**
+ * fbtft_benchmark_conversion() - Time RGB565 conversion of a frame
+ * @par: Driver data
+ *
+ * Prints the best of a few runs, in picoseconds per pixel, for the plain
+ * per-pixel loop and the conversion functions above, and for converting
+ * into coherent and streaming transmit buffers.
+ */
+void fbtft_benchmark_conversion(struct fbtft_par *par)
+{
+	size_t n = par->info->var.xres * par->info->var.yres;
+	const u16 *src = (const u16 *)par->info->screen_base;
+	s64 scalar = S64_MAX, be16 = S64_MAX, bus9 = S64_MAX;
+	ktime_t start;
+	u16 *dst;
+	size_t j;
+	int i;
+
+	if (par->info->var.bits_per_pixel != 16)
+		return;
+
+	dst = vmalloc(n * 4);
+	if (!dst)
+		return;
+
+	for (i = 0; i < FBTFT_BENCH_RUNS; i++) {
+		start = ktime_get();
+		for (j = 0; j < n; j++)
+			dst[j] = cpu_to_be16(src[j]);
+		scalar = min(scalar, ktime_to_ns(ktime_sub(ktime_get(), start)));
+
+		start = ktime_get();
+		fbtft_cpu_to_be16_buf(dst, src, n);
+		be16 = min(be16, ktime_to_ns(ktime_sub(ktime_get(), start)));
+
+		start = ktime_get();
+		fbtft_cpu_to_bus9_buf(dst, src, n);
+		bus9 = min(bus9, ktime_to_ns(ktime_sub(ktime_get(), start)));
+	}
+	vfree(dst);
+
+	dev_info(par->info->device,
+		"RGB565 conversion (%s), ps/pixel: loop %llu, be16 %llu, bus9 %llu\n",
+		fbtft_neon_usable(n) ? "neon" : "words",
+		fbtft_ps_per_pixel(scalar, n), fbtft_ps_per_pixel(be16, n),
+		fbtft_ps_per_pixel(bus9, n));
 
+	fbtft_benchmark_txbuf(par, n);
+}
 
 
 
@@ -126,6 +667,83 @@ EXPORT_SYMBOL(fbtft_write_reg8_bus9);
  *
  *****************************************************************************/
 
+/*
+ * RGB565 video memory is already in bus byte order,
+ * or the SPI master takes care of it with 16-bit words.
+ */
+static bool fbtft_vmem_bus_order(struct fbtft_par *par)
+{
+#ifdef __BIG_ENDIAN
+	return true;
+#else
+	return par->bigendian || par->littleendian || par->spi16;
+#endif
+}
+
+/* video memory is DMA mapped and goes out over plain SPI */
+static bool fbtft_vmem_sg_usable(struct fbtft_par *par)
+{
+	return par->vmem_sg.nents && !par->startbyte &&
+	       par->fbtftops.write == fbtft_write_spi;
+}
+
+/*
+ * Byteswap chunk N+1 into one transmit buffer while chunk N is
+ * transferred from the other.
+ */
+static int write_vmem16_bus8_pipelined(struct fbtft_par *par, u16 *vmem16,
+								size_t remain)
+{
+	struct fbtft_pipe_xfer *x;
+	u16 *txbuf16;
+	size_t to_copy;
+	size_t tx_array_size;
+	size_t startbyte_size = 0;
+	int i, n = 0;
+	int ret = 0, ret2;
+
+	tx_array_size = par->txbuf.len / 2;
+	if (par->startbyte) {
+		tx_array_size -= 2;
+		startbyte_size = 1;
+	}
+
+	while (remain) {
+		x = &par->pipe[n];
+		ret = fbtft_write_spi_wait(par, x);
+		if (ret < 0)
+			break;
+
+		if (par->startbyte)
+			*(u8 *)x->buf = par->startbyte | 0x2;
+		txbuf16 = x->buf + startbyte_size;
+		to_copy = remain > tx_array_size ? tx_array_size : remain;
+		dev_dbg(par->info->device, "    to_copy=%zu, remain=%zu\n",
+						to_copy, remain - to_copy);
+
+		if (fbtft_vmem_bus_order(par))
+			memcpy(txbuf16, vmem16, to_copy * 2);
+		else
+			fbtft_cpu_to_be16_buf(txbuf16, vmem16, to_copy);
+
+		vmem16 = vmem16 + to_copy;
+		ret = fbtft_write_spi_async(par, x,
+						startbyte_size + to_copy * 2);
+		if (ret < 0)
+			break;
+		remain -= to_copy;
+		n = (n + 1) % FBTFT_PIPE_DEPTH;
+	}
+
+	for (i = 0; i < FBTFT_PIPE_DEPTH; i++) {
+		ret2 = fbtft_write_spi_wait(par, &par->pipe[i]);
+		if (ret2 < 0 && ret >= 0)
+			ret = ret2;
+	}
+
+	return ret;
+}
+
 /* 16 bit pixel over 8-bit databus */
 int fbtft_write_vmem16_bus8(struct fbtft_par *par, size_t offset, size_t len)
 {
@@ -134,7 +752,6 @@ int fbtft_write_vmem16_bus8(struct fbtft_par *par, size_t offset, size_t len)
 	size_t remain;
 	size_t to_copy;
 	size_t tx_array_size;
-	int i;
 	int ret = 0;
 	size_t startbyte_size = 0;
 
@@ -144,13 +761,35 @@ int fbtft_write_vmem16_bus8(struct fbtft_par *par, size_t offset, size_t len)
 	remain = len / 2;
 	vmem16 = (u16 *)(par->info->screen_base + offset);
 
+	/* only the buffered write sends queued commands along */
+	if (!par->txbuf.buf ||
+	    (fbtft_vmem_bus_order(par) &&
+	     (fbtft_vmem_sg_usable(par) || par->pdev)) ||
+	    (par->pipe[1].buf && par->fbtftops.write == fbtft_write_spi)) {
+		ret = fbtft_cmdq_submit(par);
+		if (ret < 0)
+			return ret;
+	}
+
 	if (par->gpio.dc != -1)
 		gpio_set_value(par->gpio.dc, 1);
 
+	if (fbtft_vmem_bus_order(par)) {
+		if (fbtft_vmem_sg_usable(par))
+			return fbtft_write_spi_vmem_sg(par, offset, len);
+		/* no DMA to worry about on the parallel bus */
+		if (par->pdev)
+			return par->fbtftops.write(par, vmem16, len);
+	}
+
 	/* non buffered write */
 	if (!par->txbuf.buf)
 		return par->fbtftops.write(par, vmem16, len);
 
+	/* spi_async() is only used for plain SPI writes */
+	if (par->pipe[1].buf && par->fbtftops.write == fbtft_write_spi)
+		return write_vmem16_bus8_pipelined(par, vmem16, remain);
+
 	/* buffered write */
 	tx_array_size = par->txbuf.len / 2;
 
@@ -166,11 +805,23 @@ int fbtft_write_vmem16_bus8(struct fbtft_par *par, size_t offset, size_t len)
 		dev_dbg(par->info->device, "    to_copy=%zu, remain=%zu\n",
 						to_copy, remain - to_copy);
 
-		for (i = 0; i < to_copy; i++)
-			txbuf16[i] = cpu_to_be16(vmem16[i]);
+		if (fbtft_vmem_bus_order(par))
+			memcpy(txbuf16, vmem16, to_copy * 2);
+		else
+			fbtft_cpu_to_be16_buf(txbuf16, vmem16, to_copy);
 
 		vmem16 = vmem16 + to_copy;
-		ret = par->fbtftops.write(par, par->txbuf.buf,
+		if (par->cmdq.num) {
+			/* with set_addr_win(), in the same wait */
+			fbtft_cmdq_add_ref(par, true, par->txbuf.buf,
+				startbyte_size + to_copy * 2, par->txbuf.dma,
+				par->spi16 ? 16 : 0);
+			ret = fbtft_cmdq_submit(par);
+		} else if (par->spi16)
+			ret = fbtft_write_spi16(par, par->txbuf.buf,
+							to_copy * 2);
+		else
+			ret = par->fbtftops.write(par, par->txbuf.buf,
 						startbyte_size + to_copy * 2);
 		if (ret < 0)
 			return ret;
@@ -189,7 +840,6 @@ int fbtft_write_vmem16_bus9(struct fbtft_par *par, size_t offset, size_t len)
 	size_t remain;
 	size_t to_copy;
 	size_t tx_array_size;
-	int i;
 	int ret = 0;
 
 	fbtft_par_dbg(DEBUG_WRITE_VMEM, par, "%s(offset=%zu, len=%zu)\n",
@@ -203,22 +853,15 @@ int fbtft_write_vmem16_bus9(struct fbtft_par *par, size_t offset, size_t len)
 	remain = len;
 	vmem8 = par->info->screen_base + offset;
 
-	tx_array_size = par->txbuf.len / 2;
+	/* whole pixels */
+	tx_array_size = (par->txbuf.len / 2) & ~1;
 
 	while (remain) {
 		to_copy = remain > tx_array_size ? tx_array_size : remain;
 		dev_dbg(par->info->device, "    to_copy=%zu, remain=%zu\n",
 						to_copy, remain - to_copy);
 
-#ifdef __LITTLE_ENDIAN
-		for (i = 0; i < to_copy; i += 2) {
-			txbuf16[i]   = 0x0100 | vmem8[i+1];
-			txbuf16[i+1] = 0x0100 | vmem8[i];
-		}
-#else
-		for (i = 0; i < to_copy; i++)
-			txbuf16[i]   = 0x0100 | vmem8[i];
-#endif
+		fbtft_cpu_to_bus9_buf(txbuf16, (u16 *)vmem8, to_copy / 2);
 		vmem8 = vmem8 + to_copy;
 		ret = par->fbtftops.write(par, par->txbuf.buf, to_copy*2);
 		if (ret < 0)
@@ -250,6 +893,9 @@ int fbtft_write_vmem16_bus16(struct fbtft_par *par, size_t offset, size_t len)
 	if (par->gpio.dc != -1)
 		gpio_set_value(par->gpio.dc, 1);
 
+	if (fbtft_vmem_sg_usable(par))
+		return fbtft_write_spi_vmem_sg(par, offset, len);
+
 	/* no need for buffered write with 16-bit bus */
 	return par->fbtftops.write(par, vmem16, len);
 }
@@ -37,8 +37,14 @@
 #include <linux/platform_device.h>
 #include <linux/spinlock.h>
 #include <linux/dma-mapping.h>
+#include <linux/scatterlist.h>
+#include <linux/swab.h>
 #include <linux/of.h>
 #include <linux/of_gpio.h>
+#include <linux/hrtimer.h>
+#include <linux/interrupt.h>
+#include <linux/kthread.h>
+#include <linux/sched.h>
 
 #include "fbtft.h"
 
@@ -56,6 +62,78 @@ static bool dma = true;
 module_param(dma, bool, 0);
 MODULE_PARM_DESC(dma, "Use DMA buffer");
 
+static bool chain;
+module_param(chain, bool, 0);
+MODULE_PARM_DESC(chain, "Send a frame in one SPI message, in transfers of the driver's txbuflen (uses a frame sized buffer)");
+
+static bool cmdq;
+module_param(cmdq, bool, 0);
+MODULE_PARM_DESC(cmdq, "Experimental: Queue set_addr_win() and init sequence register writes, wait once for them (8-bit SPI)");
+
+static bool streaming;
+module_param(streaming, bool, 0);
+MODULE_PARM_DESC(streaming, "Use cached DMA buffers, synced for each transfer, instead of uncached coherent ones");
+
+static bool zerocopy = true;
+module_param(zerocopy, bool, 0);
+MODULE_PARM_DESC(zerocopy, "DMA video memory directly when no pixel conversion is needed (SPI)");
+
+static bool bigendian;
+module_param(bigendian, bool, 0);
+MODULE_PARM_DESC(bigendian, "Keep RGB565 video memory in bus byte order, no byteswapping (8-bit bus)");
+
+static bool littleendian;
+module_param(littleendian, bool, 0);
+MODULE_PARM_DESC(littleendian, "Set up the controller for little endian RGB565 if it can, no byteswapping (8-bit parallel bus)");
+
+static bool spi16;
+module_param(spi16, bool, 0);
+MODULE_PARM_DESC(spi16, "Send pixels as 16-bit SPI words if the master can, no byteswapping (8-bit bus)");
+
+static bool benchmark;
+module_param(benchmark, bool, 0);
+MODULE_PARM_DESC(benchmark, "Time RGB565 conversion and coherent vs streaming transmit buffers when registering");
+
+static bool pipeline = true;
+module_param(pipeline, bool, 0);
+MODULE_PARM_DESC(pipeline, "Convert pixels while the previous chunk is transferred (SPI)");
+
+static bool worker = true;
+module_param(worker, bool, 0);
+MODULE_PARM_DESC(worker, "Update the display from a dedicated kernel thread");
+
+static int worker_prio;
+module_param(worker_prio, int, 0);
+MODULE_PARM_DESC(worker_prio, "SCHED_FIFO priority of the worker (default: 0 = SCHED_NORMAL)");
+
+static int worker_cpu = -1;
+module_param(worker_cpu, int, 0);
+MODULE_PARM_DESC(worker_cpu, "Bind the worker to this CPU (default: -1 = any)");
+
+static bool pace = true;
+module_param(pace, bool, 0);
+MODULE_PARM_DESC(pace, "Pace updates to fps, otherwise update as fast as the bus allows");
+
+static bool te_poll;
+module_param(te_poll, bool, 0);
+MODULE_PARM_DESC(te_poll, "Without a TE gpio, poll the DCS scanline before updates (SPI)");
+
+static bool manual;
+module_param(manual, bool, 0);
+MODULE_PARM_DESC(manual, "Don't track writes to mmap'ed video memory, userspace flushes damage (FBTFT_IOCTL_FLUSH)");
+
+static unsigned frames = 1;
+module_param(frames, uint, 0);
+MODULE_PARM_DESC(frames, "Frames in video memory for page flipping (1-3, default: 1)");
+
+static bool vscroll;
+module_param(vscroll, bool, 0);
+MODULE_PARM_DESC(vscroll, "Scroll fbcon with the controller's vertical scrolling if supported (implies frames=1)");
+
+static bool shadow;
+module_param(shadow, bool, 0);
+MODULE_PARM_DESC(shadow, "Only transfer tiles that changed since the last update");
+
 
 void fbtft_dbg_hex(const struct device *dev, int groupsize,
 			void *buf, size_t len, const char *fmt, ...)
@@ -106,6 +184,9 @@ unsigned long fbtft_request_gpios_match(struct fbtft_par *par,
 	} else if (strcasecmp(gpio->name, "latch") == 0) {
 		par->gpio.latch = gpio->gpio;
 		return GPIOF_OUT_INIT_LOW;
+	} else if (strcasecmp(gpio->name, "te") == 0) {
+		par->gpio.te = gpio->gpio;
+		return GPIOF_IN;
 	} else if (gpio->name[0] == 'd' && gpio->name[1] == 'b') {
 		ret = kstrtol(&gpio->name[2], 10, &val);
 		if (ret == 0 && val < 16) {
@@ -186,6 +267,9 @@ static int fbtft_request_one_gpio(struct fbtft_par *par,
 		/* active low translates to initially low */
 		flags = (of_flags & OF_GPIO_ACTIVE_LOW) ? GPIOF_OUT_INIT_LOW :
 							GPIOF_OUT_INIT_HIGH;
+		/* tearing effect is the only input */
+		if (gpiop == &par->gpio.te)
+			flags = GPIOF_IN;
 		ret = devm_gpio_request_one(dev, gpio, flags,
 						dev->driver->name);
 		if (ret) {
@@ -227,6 +311,9 @@ static int fbtft_request_gpios_dt(struct fbtft_par *par)
 	if (ret)
 		return ret;
 	ret = fbtft_request_one_gpio(par, "latch-gpios", 0, &par->gpio.latch);
+	if (ret)
+		return ret;
+	ret = fbtft_request_one_gpio(par, "te-gpios", 0, &par->gpio.te);
 	if (ret)
 		return ret;
 	for (i = 0; i < 16; i++) {
@@ -337,23 +424,129 @@ void fbtft_unregister_backlight(struct fbtft_par *par) { };
 EXPORT_SYMBOL(fbtft_register_backlight);
 EXPORT_SYMBOL(fbtft_unregister_backlight);
 
+/**
+ * fbtft_addr_win_set() - Record the window the controller was given
+ * @par: Driver data
+ * @xs: First column
+ * @ys: First line
+ * @xe: Last column
+ * @ye: Last line the write pointer can run on to
+ */
+void fbtft_addr_win_set(struct fbtft_par *par, int xs, int ys, int xe, int ye)
+{
+	par->addr_win.xs = xs;
+	par->addr_win.ys = ys;
+	par->addr_win.xe = xe;
+	par->addr_win.ye = ye;
+}
+EXPORT_SYMBOL(fbtft_addr_win_set);
+
+/**
+ * fbtft_addr_win_invalidate() - Forget the window the controller was given
+ * @par: Driver data
+ *
+ * Called when the controller might have lost it, the next set_addr_win()
+ * writes all of it.
+ */
+void fbtft_addr_win_invalidate(struct fbtft_par *par)
+{
+	fbtft_addr_win_set(par, -1, -1, -1, -1);
+	par->addr_win.next = -1;
+}
+EXPORT_SYMBOL(fbtft_addr_win_invalidate);
+
+/**
+ * fbtft_addr_win_continues() - Check if a window follows on from the last
+ * @par: Driver data
+ * @xs: First column
+ * @ys: First line
+ * @xe: Last column
+ * @ye: Last line
+ *
+ * True when the previous window had the same columns and ended on the line
+ * above @ys, with no register written since.
+ *
+ * Return: true if the pixels can be written without setting the address
+ */
+bool fbtft_addr_win_continues(struct fbtft_par *par, int xs, int ys, int xe,
+			      int ye)
+{
+	return par->addr_win.next == ys && par->addr_win.xs == xs &&
+	       par->addr_win.xe == xe && ye <= par->addr_win.ye;
+}
+EXPORT_SYMBOL(fbtft_addr_win_continues);
+
+/**
+ * fbtft_set_addr_win() - MIPI DCS address window
+ * @par: Driver data
+ * @xs: First column
+ * @ys: First line
+ * @xe: Last column
+ * @ye: Last line
+ *
+ * The rows run on to the bottom of the display, so a window below it with
+ * the same columns can continue writing, and the row address only changes
+ * with @ys. Column and row addresses the controller already has are not
+ * sent again.
+ */
 void fbtft_set_addr_win(struct fbtft_par *par, int xs, int ys, int xe, int ye)
 {
+	int yend = max_t(int, ye, par->info->var.yres - 1);
+
 	fbtft_par_dbg(DEBUG_SET_ADDR_WIN, par,
 		"%s(xs=%d, ys=%d, xe=%d, ye=%d)\n", __func__, xs, ys, xe, ye);
 
+	if ((par->caps & FBTFT_CAP_RAMWR_CONT) &&
+	    fbtft_addr_win_continues(par, xs, ys, xe, ye)) {
+		/* Memory write continue */
+		write_reg(par, FBTFT_RAMWR_CONT);
+		return;
+	}
+
 	/* Column address set */
-	write_reg(par, 0x2A,
-		(xs >> 8) & 0xFF, xs & 0xFF, (xe >> 8) & 0xFF, xe & 0xFF);
+	if (xs != par->addr_win.xs || xe != par->addr_win.xe)
+		write_reg(par, FBTFT_CASET,
+			(xs >> 8) & 0xFF, xs & 0xFF,
+			(xe >> 8) & 0xFF, xe & 0xFF);
 
 	/* Row adress set */
-	write_reg(par, 0x2B,
-		(ys >> 8) & 0xFF, ys & 0xFF, (ye >> 8) & 0xFF, ye & 0xFF);
+	if (ys != par->addr_win.ys || yend != par->addr_win.ye)
+		write_reg(par, FBTFT_RASET,
+			(ys >> 8) & 0xFF, ys & 0xFF,
+			(yend >> 8) & 0xFF, yend & 0xFF);
 
 	/* Memory write */
-	write_reg(par, 0x2C);
+	write_reg(par, FBTFT_RAMWR);
+
+	fbtft_addr_win_set(par, xs, ys, xe, yend);
 }
+EXPORT_SYMBOL(fbtft_set_addr_win);
+
+/**
+ * fbtft_set_scroll_dcs() - MIPI DCS vertical scrolling
+ * @par: Driver data
+ * @lines: Lines of frame memory
+ * @line: Frame memory line to show at the top of the display
+ *
+ * The scrolling area is the whole display, any frame memory lines below
+ * it are fixed.
+ */
+void fbtft_set_scroll_dcs(struct fbtft_par *par, unsigned lines, unsigned line)
+{
+	unsigned height = par->info->var.yres;
+	unsigned bfa = lines - height;
+
+	fbtft_par_dbg(DEBUG_UPDATE_DISPLAY, par, "%s(line=%u)\n",
+		__func__, line);
 
+	/* Vertical scrolling definition: top fixed, scroll, bottom fixed */
+	write_reg(par, 0x33, 0x00, 0x00, (height >> 8) & 0xFF, height & 0xFF,
+		(bfa >> 8) & 0xFF, bfa & 0xFF);
+
+	/* Vertical scrolling start address */
+	write_reg(par, 0x37, (line >> 8) & 0xFF, line & 0xFF);
+}
+EXPORT_SYMBOL(fbtft_set_scroll_dcs);
 
 void fbtft_reset(struct fbtft_par *par)
 {
@@ -367,13 +560,195 @@ void fbtft_reset(struct fbtft_par *par)
 }
 
 
-void fbtft_update_display(struct fbtft_par *par, unsigned start_line, unsigned end_line)
+static size_t fbtft_window_len(struct fbtft_par *par, unsigned xs,
+				unsigned ys, unsigned xe, unsigned ye)
+{
+	return (xe - xs + 1) * (ye - ys + 1) *
+		par->info->var.bits_per_pixel / 8;
+}
+
+/* Transfers a window of video memory to the display */
+static int fbtft_write_window(struct fbtft_par *par, unsigned xs, unsigned ys,
+						unsigned xe, unsigned ye)
+{
+	struct fb_info *info = par->info;
+	size_t offset, len;
+	unsigned y;
+	int ret = 0;
+	int err;
+
+	if (par->fbtftops.set_addr_win) {
+		fbtft_cmdq_open(par);
+		par->fbtftops.set_addr_win(par, xs, ys, xe, ye);
+		/* the default write_vmem() can send it with the first pixels */
+		if (par->fbtftops.write_vmem != fbtft_write_vmem16_bus8) {
+			ret = fbtft_cmdq_submit(par);
+			if (ret < 0)
+				goto out;
+		}
+	}
+
+	offset = par->update.offset + ys * info->fix.line_length +
+		 xs * info->var.bits_per_pixel / 8;
+
+	/* whole lines are contiguous in video memory */
+	if (xs == 0 && xe == info->var.xres - 1) {
+		ret = par->fbtftops.write_vmem(par, offset,
+				(ye - ys + 1) * info->fix.line_length);
+		goto out;
+	}
+
+	/* the controller wraps to the next line at xe */
+	len = (xe - xs + 1) * info->var.bits_per_pixel / 8;
+	for (y = ys; y <= ye; y++) {
+		ret = par->fbtftops.write_vmem(par, offset, len);
+		if (ret < 0)
+			break;
+		offset += info->fix.line_length;
+	}
+
+out:
+	/* in case write_vmem() didn't send it */
+	err = fbtft_cmdq_submit(par);
+	if (ret >= 0)
+		ret = err;
+
+	if (ret < 0) {
+		/* the controller may have missed some of it */
+		fbtft_addr_win_invalidate(par);
+		return ret;
+	}
+
+	/* the write pointer is at the start of the line below */
+	if ((int)ye < par->addr_win.ye)
+		par->addr_win.next = ye + 1;
+
+	return 0;
+}
+
+/*
+ * Compares the window with the last transmitted frame, tile by tile, and
+ * adds the tiles that changed to @damage. The shadow copy is updated as
+ * we go, so pixels written to vmem after their tile was compared are
+ * picked up by the next update.
+ */
+static void fbtft_shadow_diff(struct fbtft_par *par,
+				struct fbtft_damage *damage,
+				unsigned xs, unsigned ys, unsigned xe, unsigned ye)
 {
+	struct fb_info *info = par->info;
+	u8 *vmem = (u8 __force *)info->screen_base + par->update.offset;
+	u8 *shadow = par->shadow.buf;
+	unsigned tile_w = FBTFT_TILE_SIZE;
+	unsigned tx, ty, txe, tye, y;
 	size_t offset, len;
+	bool changed;
+
+	/* tiles are bands of whole lines on these controllers */
+	if (!(par->caps & FBTFT_CAP_ADDR_WIN_X))
+		tile_w = info->var.xres;
+
+	for (ty = ys; ty <= ye; ty = tye + 1) {
+		tye = min(ty - ty % FBTFT_TILE_SIZE + FBTFT_TILE_SIZE - 1, ye);
+		for (tx = xs; tx <= xe; tx = txe + 1) {
+			txe = min(tx - tx % tile_w + tile_w - 1, xe);
+			len = (txe - tx + 1) * info->var.bits_per_pixel / 8;
+			changed = false;
+			for (y = ty; y <= tye; y++) {
+				offset = y * info->fix.line_length +
+					 tx * info->var.bits_per_pixel / 8;
+				if (!changed &&
+				    !memcmp(vmem + offset, shadow + offset, len))
+					continue;
+				changed = true;
+				memcpy(shadow + offset, vmem + offset, len);
+			}
+			if (changed)
+				fbtft_damage_add(par, damage, tx, ty, txe, tye);
+			else
+				par->shadow.saved += len * (tye - ty + 1);
+		}
+	}
+}
+
+/*
+ * Makes the shadow copy of a window differ from video memory, so the
+ * window is sent again on its next update. Used when sending it failed.
+ */
+static void fbtft_shadow_invalidate(struct fbtft_par *par,
+				    const struct fbtft_rect *rect)
+{
+	struct fb_info *info = par->info;
+	u8 *vmem = (u8 __force *)info->screen_base + par->update.offset;
+	size_t len = (rect->xe - rect->xs + 1) * info->var.bits_per_pixel / 8;
+	size_t offset, j;
+	unsigned y;
+
+	for (y = rect->ys; y <= rect->ye; y++) {
+		offset = y * info->fix.line_length +
+			 rect->xs * info->var.bits_per_pixel / 8;
+		for (j = 0; j < len; j++)
+			par->shadow.buf[offset + j] = ~vmem[offset + j];
+	}
+}
+
+static int fbtft_shadow_alloc(struct fbtft_par *par)
+{
+	struct fb_info *info = par->info;
+	size_t len = info->fix.line_length * info->var.yres;
+
+	par->shadow.buf = vmalloc(len);
+	if (!par->shadow.buf)
+		return -ENOMEM;
+	memcpy(par->shadow.buf,
+		(u8 __force *)info->screen_base + par->update.offset, len);
+
+	return 0;
+}
+
+/**
+ * fbtft_shadow_set() - Turn frame differencing on or off
+ * @par: Driver data
+ * @enable: true to only transfer the tiles that changed
+ *
+ * When turned on, the whole display is transferred so it is known to
+ * match the shadow copy.
+ *
+ * Return: 0 if successful, negative if error
+ */
+int fbtft_shadow_set(struct fbtft_par *par, bool enable)
+{
+	struct fb_info *info = par->info;
+	u8 *shadow = NULL;
+	int ret = 0;
+
+	mutex_lock(&par->update.lock);
+	if (enable && !par->shadow.buf) {
+		ret = fbtft_shadow_alloc(par);
+		if (!ret)
+			ret = fbtft_write_window(par, 0, 0,
+				info->var.xres - 1, info->var.yres - 1);
+	} else if (!enable) {
+		shadow = par->shadow.buf;
+		par->shadow.buf = NULL;
+	}
+	mutex_unlock(&par->update.lock);
+	vfree(shadow);
+
+	return ret;
+}
+
+void fbtft_update_display(struct fbtft_par *par, unsigned xs, unsigned ys,
+						unsigned xe, unsigned ye)
+{
+	struct fb_info *info = par->info;
+	size_t len;
 	struct timespec ts_start, ts_end, ts_fps, ts_duration;
 	long fps_ms, fps_us, duration_ms, duration_us;
 	long fps, throughput;
+	struct fbtft_rect win, *rects;
 	bool timeit = false;
+	unsigned i, num;
 	int ret = 0;
 
 	if (unlikely(par->debug & (DEBUG_TIME_FIRST_UPDATE | DEBUG_TIME_EACH_UPDATE))) {
@@ -385,35 +760,70 @@ void fbtft_update_display(struct fbtft_par *par, unsigned start_line, unsigned e
 	}
 
 	/* Sanity checks */
-	if (start_line > end_line) {
-		dev_warn(par->info->device,
+	if (ys > ye) {
+		dev_warn(info->device,
 			"%s: start_line=%u is larger than end_line=%u. Shouldn't happen, will do full display update\n",
-			__func__, start_line, end_line);
-		start_line = 0;
-		end_line = par->info->var.yres - 1;
+			__func__, ys, ye);
+		ys = 0;
+		ye = info->var.yres - 1;
 	}
-	if (start_line > par->info->var.yres - 1 || end_line > par->info->var.yres - 1) {
-		dev_warn(par->info->device,
+	if (ys > info->var.yres - 1 || ye > info->var.yres - 1) {
+		dev_warn(info->device,
 			"%s: start_line=%u or end_line=%u is larger than max=%d. Shouldn't happen, will do full display update\n",
-			__func__, start_line, end_line, par->info->var.yres - 1);
-		start_line = 0;
-		end_line = par->info->var.yres - 1;
+			__func__, ys, ye, info->var.yres - 1);
+		ys = 0;
+		ye = info->var.yres - 1;
+	}
+	if (xs > xe || xe > info->var.xres - 1) {
+		dev_warn(info->device,
+			"%s: start_col=%u or end_col=%u is out of range (max=%d). Shouldn't happen, will update whole lines\n",
+			__func__, xs, xe, info->var.xres - 1);
+		xs = 0;
+		xe = info->var.xres - 1;
 	}
 
-	fbtft_par_dbg(DEBUG_UPDATE_DISPLAY, par, "%s(start_line=%u, end_line=%u)\n",
-		__func__, start_line, end_line);
+	/* controller can only be addressed in whole lines */
+	if (!(par->caps & FBTFT_CAP_ADDR_WIN_X)) {
+		xs = 0;
+		xe = info->var.xres - 1;
+	}
 
-	if (par->fbtftops.set_addr_win)
-		par->fbtftops.set_addr_win(par, 0, start_line,
-				par->info->var.xres-1, end_line);
+	fbtft_par_dbg(DEBUG_UPDATE_DISPLAY, par,
+		"%s(xs=%u, ys=%u, xe=%u, ye=%u)\n", __func__, xs, ys, xe, ye);
 
-	offset = start_line * par->info->fix.line_length;
-	len = (end_line - start_line + 1) * par->info->fix.line_length;
-	ret = par->fbtftops.write_vmem(par, offset, len);
-	if (ret < 0)
-		dev_err(par->info->device,
-			"%s: write_vmem failed to update display buffer\n",
-			__func__);
+	if (par->shadow.buf) {
+		par->shadow.damage.num = 0;
+		fbtft_shadow_diff(par, &par->shadow.damage, xs, ys, xe, ye);
+		rects = par->shadow.damage.rect;
+		num = par->shadow.damage.num;
+	} else {
+		win.xs = xs;
+		win.ys = ys;
+		win.xe = xe;
+		win.ye = ye;
+		rects = &win;
+		num = 1;
+	}
+
+	len = 0;
+	for (i = 0; i < num; i++) {
+		ret = fbtft_write_window(par, rects[i].xs, rects[i].ys,
+						rects[i].xe, rects[i].ye);
+		if (ret < 0) {
+			dev_err(info->device,
+				"%s: write_vmem failed to update display buffer\n",
+				__func__);
+			break;
+		}
+		len += fbtft_window_len(par, rects[i].xs, rects[i].ys,
+						rects[i].xe, rects[i].ye);
+	}
+	par->bytes_sent += len;
+
+	/* the shadow copy was updated for windows that weren't sent */
+	if (par->shadow.buf)
+		for (; i < num; i++)
+			fbtft_shadow_invalidate(par, &rects[i]);
 
 	if (unlikely(timeit)) {
 		getnstimeofday(&ts_end);
@@ -445,47 +855,516 @@ void fbtft_update_display(struct fbtft_par *par, unsigned start_line, unsigned e
 }
 
 
-void fbtft_mkdirty(struct fb_info *info, int y, int height)
+/*
+ * Estimated cost of updating a window, in bytes on the bus: the pixels,
+ * one set_addr_win() and for partial lines one write_vmem() per line.
+ */
+static long fbtft_damage_cost(struct fbtft_par *par,
+				const struct fbtft_rect *rect)
+{
+	long width = rect->xe - rect->xs + 1;
+	long height = rect->ye - rect->ys + 1;
+	long cost;
+
+	cost = FBTFT_DAMAGE_WIN_COST +
+		width * height * par->info->var.bits_per_pixel / 8;
+	if (width != par->info->var.xres)
+		cost += height * FBTFT_DAMAGE_LINE_COST;
+
+	return cost;
+}
+
+static void fbtft_rect_union(struct fbtft_rect *dst,
+			const struct fbtft_rect *a, const struct fbtft_rect *b)
+{
+	dst->xs = min(a->xs, b->xs);
+	dst->ys = min(a->ys, b->ys);
+	dst->xe = max(a->xe, b->xe);
+	dst->ye = max(a->ye, b->ye);
+}
+
+/**
+ * fbtft_damage_add() - Add a window to a damage list
+ * @par: Driver data
+ * @damage: Damage list
+ * @xs: First column
+ * @ys: First line
+ * @xe: Last column
+ * @ye: Last line
+ *
+ * The window is merged with the ones already on the list as long as
+ * updating the union costs no more than updating them separately.
+ * When the list is full, it is merged with the window that gets the
+ * cheapest union.
+ */
+void fbtft_damage_add(struct fbtft_par *par, struct fbtft_damage *damage,
+			unsigned xs, unsigned ys, unsigned xe, unsigned ye)
+{
+	struct fbtft_rect rect, u;
+	long cost, best_cost;
+	unsigned i, best;
+
+	rect.xs = xs;
+	rect.ys = ys;
+	rect.xe = xe;
+	rect.ye = ye;
+	if (!(par->caps & FBTFT_CAP_ADDR_WIN_X)) {
+		rect.xs = 0;
+		rect.xe = par->info->var.xres - 1;
+	}
+
+retry:
+	for (i = 0; i < damage->num; i++) {
+		fbtft_rect_union(&u, &damage->rect[i], &rect);
+		if (fbtft_damage_cost(par, &u) <=
+				fbtft_damage_cost(par, &damage->rect[i]) +
+				fbtft_damage_cost(par, &rect)) {
+			/* the union may now absorb other windows */
+			rect = u;
+			damage->rect[i] = damage->rect[--damage->num];
+			goto retry;
+		}
+	}
+
+	if (damage->num < FBTFT_DAMAGE_MAX) {
+		damage->rect[damage->num++] = rect;
+		return;
+	}
+
+	best = 0;
+	best_cost = LONG_MAX;
+	for (i = 0; i < damage->num; i++) {
+		fbtft_rect_union(&u, &damage->rect[i], &rect);
+		cost = fbtft_damage_cost(par, &u) -
+			fbtft_damage_cost(par, &damage->rect[i]);
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = i;
+		}
+	}
+	fbtft_rect_union(&rect, &damage->rect[best], &rect);
+	damage->rect[best] = damage->rect[--damage->num];
+	goto retry;
+}
+EXPORT_SYMBOL(fbtft_damage_add);
+
+/*
+ * Adds a window in video memory coordinates to the damage list, clipped
+ * to the front buffer. Caller holds dirty_lock.
+ */
+static void fbtft_mark_dirty(struct fbtft_par *par, unsigned xs, unsigned ys,
+			     unsigned xe, unsigned ye)
+{
+	unsigned front = par->update.yoffset;
+	unsigned back = front + par->info->var.yres;
+
+	if (ye < front || ys >= back)
+		return;
+	ys = max(ys, front) - front;
+	ye = min(ye, back - 1) - front;
+	fbtft_damage_add(par, par->damage, xs, ys, xe, ye);
+}
+
+/*
+ * Jiffies until the next update is due, 0 if no update is in progress and
+ * the update period has passed
+ */
+static unsigned long fbtft_update_delay(struct fbtft_par *par)
+{
+	ktime_t next = ktime_add_ns(par->update.last, par->update.target);
+	s64 remaining = ktime_to_ns(ktime_sub(next, ktime_get()));
+	unsigned long delay;
+
+	if (remaining <= 0)
+		return mutex_is_locked(&par->update.lock) ? 1 : 0;
+
+	delay = usecs_to_jiffies(div_u64(remaining, NSEC_PER_USEC));
+
+	return delay ? delay : 1;
+}
+
+/* Schedules deferred io, right away if the pipe is idle */
+static void fbtft_update_schedule(struct fbtft_par *par)
+{
+	struct fb_info *info = par->info;
+	unsigned long delay;
+
+	delay = fbtft_update_delay(par);
+
+	/* Schedule deferred_io to update display (no-op if already on queue)*/
+	schedule_delayed_work(&info->deferred_work, delay);
+}
+
+void fbtft_mkdirty(struct fb_info *info, int x, int y, int width, int height)
 {
 	struct fbtft_par *par = info->par;
-	struct fb_deferred_io *fbdefio = info->fbdefio;
 
 	/* special case, needed ? */
 	if (y == -1) {
-		y = 0;
-		height = info->var.yres - 1;
+		x = 0;
+		y = par->update.yoffset;
+		width = info->var.xres;
+		height = info->var.yres;
 	}
 
-	/* Mark display lines/area as dirty */
-	spin_lock(&par->dirty_lock);
-	if (y < par->dirty_lines_start)
-		par->dirty_lines_start = y;
-	if (y + height - 1 > par->dirty_lines_end)
-		par->dirty_lines_end = y + height - 1;
-	spin_unlock(&par->dirty_lock);
+	if (width <= 0 || height <= 0)
+		return;
+
+	/* Mark display area as dirty */
+	spin_lock(&par->dirty_lock);
+	fbtft_mark_dirty(par, x, y, x + width - 1, y + height - 1);
+	spin_unlock(&par->dirty_lock);
+
+	fbtft_update_schedule(par);
+}
+
+/* Measures the update rate over windows of at least one second */
+static void fbtft_update_stats(struct fbtft_par *par, ktime_t now)
+{
+	s64 elapsed;
+
+	par->update.last = now;
+	par->update.frames++;
+	elapsed = ktime_to_ns(ktime_sub(now, par->update.window));
+	if (elapsed < NSEC_PER_SEC)
+		return;
+
+	par->update.fps_achieved = div64_u64((u64)par->update.frames *
+					NSEC_PER_SEC * 1000, elapsed);
+	par->update.frames = 0;
+	par->update.window = now;
+}
+
+/*
+ * Stretches the update period to the measured transfer time, so updates
+ * are never scheduled faster than the bus can drain them.
+ * fbtft_update_schedule() waits out the rest of the period when it
+ * schedules an update. fbdefio->delay stays as configured, page faults
+ * use it to batch damage.
+ */
+static void fbtft_update_governor(struct fbtft_par *par, ktime_t start,
+				  u64 bytes)
+{
+	u64 duration = ktime_to_ns(ktime_sub(ktime_get(), start));
+	u64 throughput;
+
+	if (!duration)
+		duration = 1;
+	throughput = div64_u64(bytes * NSEC_PER_SEC, duration);
+
+	/* moving average over roughly the last 8 updates */
+	if (par->update.duration) {
+		duration = ((u64)par->update.duration * 7 + duration) >> 3;
+		throughput = ((u64)par->update.throughput * 7 + throughput) >> 3;
+	}
+	par->update.duration = duration;
+	par->update.throughput = throughput;
+	par->update.target = max(par->update.period, par->update.duration);
+}
+
+static irqreturn_t fbtft_te_irq(int irq, void *data)
+{
+	struct fbtft_par *par = data;
+
+	complete(&par->te.done);
+
+	return IRQ_HANDLED;
+}
+
+/* DCS Get Scanline: dummy byte, GTS[9:8], GTS[7:0] */
+static int fbtft_read_scanline(struct fbtft_par *par)
+{
+	u8 buf[3];
+	int ret;
+
+	ret = fbtft_read_reg8_spi(par, 0x45, buf, sizeof(buf));
+	if (ret < 0)
+		return ret;
+
+	return ((buf[1] & 0x03) << 8) | buf[2];
+}
+
+/*
+ * Busy polls the scanline until it wraps around to a new frame.
+ * A scanline that doesn't move reads back as a constant, so polling is
+ * turned off when it doesn't wrap a few times in a row.
+ */
+static void fbtft_te_poll(struct fbtft_par *par)
+{
+	ktime_t timeout = ktime_add_ms(ktime_get(), FBTFT_TE_TIMEOUT_MS);
+	int line, prev = -1;
+	unsigned same = 0;
+
+	while (ktime_compare(ktime_get(), timeout) < 0) {
+		line = fbtft_read_scanline(par);
+		if (line < 0) {
+			dev_warn(par->info->device,
+				"%s: reading scanline failed (%d), not polling\n",
+				__func__, line);
+			par->te.poll = false;
+			return;
+		}
+		if (line < prev) {
+			par->te.fails = 0;
+			return;
+		}
+		if (line == prev) {
+			if (++same == FBTFT_TE_POLL_SAME)
+				break;
+		} else {
+			same = 0;
+		}
+		prev = line;
+	}
+	fbtft_par_dbg(DEBUG_UPDATE_DISPLAY, par,
+		"%s: no new frame, scanline %d\n", __func__, prev);
+
+	if (++par->te.fails < FBTFT_TE_POLL_FAILS)
+		return;
+
+	dev_warn(par->info->device,
+		"%s: scanline stays at %d, not polling\n", __func__, prev);
+	par->te.poll = false;
+}
+
+/*
+ * Waits for the panel to start scanning out a new frame, so the transfer
+ * that follows stays ahead of the scan position.
+ */
+static void fbtft_te_wait(struct fbtft_par *par)
+{
+	if (par->te.irq) {
+		reinit_completion(&par->te.done);
+		if (!wait_for_completion_timeout(&par->te.done,
+					msecs_to_jiffies(FBTFT_TE_TIMEOUT_MS)))
+			fbtft_par_dbg(DEBUG_UPDATE_DISPLAY, par,
+				"%s: timeout\n", __func__);
+	} else if (par->te.poll) {
+		fbtft_te_poll(par);
+	}
+}
+
+static int fbtft_te_init(struct fbtft_par *par)
+{
+	struct device *dev = par->info->device;
+	int irq, ret;
+
+	if (!(par->caps & FBTFT_CAP_TE))
+		return 0;
+	if (par->gpio.te == -1 && !te_poll)
+		return 0;
+
+	/* Tearing effect line on, V-blank only */
+	write_reg(par, 0x35, 0x00);
+
+	if (par->gpio.te == -1) {
+		par->te.poll = true;
+		par->te.fails = 0;
+		return 0;
+	}
+
+	irq = gpio_to_irq(par->gpio.te);
+	if (irq < 0)
+		return irq;
+	ret = devm_request_irq(dev, irq, fbtft_te_irq, IRQF_TRIGGER_RISING,
+				dev->driver->name, par);
+	if (ret)
+		return ret;
+	par->te.irq = irq;
+
+	return 0;
+}
+
+/* Runs a queued drawing operation on the controller */
+static int fbtft_accel_run(struct fbtft_par *par, struct fbtft_accel *op)
+{
+	int ret = -ENOSYS;
+
+	if (op->is_copy) {
+		if (par->fbtftops.copyarea)
+			ret = par->fbtftops.copyarea(par, &op->copy);
+	} else {
+		if (par->fbtftops.fillrect)
+			ret = par->fbtftops.fillrect(par, &op->fill);
+	}
+
+	return ret;
+}
+
+/* Falls back to sending the video memory a drawing operation changed */
+static void fbtft_accel_damage(struct fbtft_par *par, struct fbtft_accel *op,
+			       struct fbtft_damage *damage)
+{
+	if (op->is_copy)
+		fbtft_damage_add(par, damage, op->copy.dx, op->copy.dy,
+				op->copy.dx + op->copy.width - 1,
+				op->copy.dy + op->copy.height - 1);
+	else
+		fbtft_damage_add(par, damage, op->fill.dx, op->fill.dy,
+				op->fill.dx + op->fill.width - 1,
+				op->fill.dy + op->fill.height - 1);
+}
+
+/* Signals FBIO_WAITFORVSYNC and poll() on the frames_pushed attribute */
+static void fbtft_frame_pushed(struct fbtft_par *par)
+{
+	par->update.pushed++;
+	wake_up_interruptible_all(&par->update.push_wait);
+	sysfs_notify(&par->info->dev->kobj, NULL, "frames_pushed");
+}
+
+/* Transfers the damage list to the display */
+static void fbtft_flush_damage(struct fbtft_par *par)
+{
+	struct fbtft_accel *accel;
+	struct fbtft_damage *damage;
+	struct fbtft_rect *rect;
+	unsigned num_accel;
+	ktime_t start;
+	int scroll;
+	u64 bytes;
+	unsigned i;
+
+	mutex_lock(&par->update.lock);
+	spin_lock(&par->dirty_lock);
+	/* set display areas as clean, new damage goes to the other list */
+	damage = par->damage;
+	par->damage = &par->damage_buf[damage == &par->damage_buf[0]];
+	par->damage->num = 0;
+	par->update.offset = par->update.yoffset * par->info->fix.line_length;
+	par->update.now = false;
+	scroll = par->update.scroll;
+	par->update.scroll = -1;
+	/* new operations go to the other queue while these are run */
+	accel = par->accel.op;
+	num_accel = par->accel.num;
+	par->accel.op = par->accel.buf[accel == par->accel.buf[0]];
+	par->accel.num = 0;
+	spin_unlock(&par->dirty_lock);
+
+	if (!damage->num && scroll < 0 && !num_accel)
+		goto out;
+
+	fbtft_te_wait(par);
+	start = ktime_get();
+	fbtft_update_stats(par, start);
+	bytes = par->bytes_sent;
+	/* scroll together with drawing the lines it exposes */
+	if (scroll >= 0)
+		par->fbtftops.set_scroll(par, scroll);
+	for (i = 0; i < num_accel; i++)
+		if (fbtft_accel_run(par, &accel[i]) < 0)
+			break;
+	/* scrolling and drawing operations move the controller's window */
+	if (scroll >= 0 || num_accel)
+		fbtft_addr_win_invalidate(par);
+	/*
+	 * Later operations may read what a failed one should have drawn,
+	 * so none of them are run and video memory is sent for all of them
+	 */
+	for (; i < num_accel; i++)
+		fbtft_accel_damage(par, &accel[i], damage);
+	for (i = 0; i < damage->num; i++) {
+		rect = &damage->rect[i];
+		par->fbtftops.update_display(par, rect->xs, rect->ys,
+						rect->xe, rect->ye);
+	}
+	fbtft_update_governor(par, start, par->bytes_sent - bytes);
+	fbtft_frame_pushed(par);
+out:
+	mutex_unlock(&par->update.lock);
+}
+
+static bool fbtft_damage_pending(struct fbtft_par *par)
+{
+	bool pending;
+
+	spin_lock(&par->dirty_lock);
+	pending = par->damage->num != 0 || par->update.scroll >= 0 ||
+		  par->accel.num != 0;
+	spin_unlock(&par->dirty_lock);
+
+	return pending;
+}
+
+/* Sleeps until one update period has passed since the last update */
+static void fbtft_update_pace(struct fbtft_par *par)
+{
+	unsigned long period = par->update.target;
+	ktime_t next;
+
+	if (!period || par->update.now)
+		return;
+
+	next = ktime_add_ns(par->update.last, period);
+	if (ktime_compare(next, ktime_get()) <= 0)
+		return;
+
+	set_current_state(TASK_INTERRUPTIBLE);
+	schedule_hrtimeout(&next, HRTIMER_MODE_ABS);
+}
+
+/* Damage is waiting for deferred io or the display or is being sent */
+static bool fbtft_update_busy(struct fbtft_par *par)
+{
+	return delayed_work_pending(&par->info->deferred_work) ||
+		fbtft_damage_pending(par) ||
+		mutex_is_locked(&par->update.lock);
+}
+
+/*
+ * Waits until the next frame has been pushed to the display, returns
+ * right away if there's nothing left to push. Called from fb_ioctl() with
+ * the fb_info lock held, which is dropped while waiting so other fb
+ * operations, panning included, can go on.
+ */
+static int fbtft_wait_for_push(struct fbtft_par *par)
+{
+	struct fb_info *info = par->info;
+	unsigned long pushed = par->update.pushed;
+	long ret;
+
+	unlock_fb_info(info);
+	ret = wait_event_interruptible_timeout(par->update.push_wait,
+			par->update.pushed != pushed || !fbtft_update_busy(par),
+			HZ);
+	/* not lock_fb_info(), fb_ioctl() unlocks it whatever happened */
+	mutex_lock(&info->lock);
+	if (ret < 0)
+		return ret;
+
+	return ret ? 0 : -ETIMEDOUT;
+}
+
+static int fbtft_update_thread(void *data)
+{
+	struct fbtft_par *par = data;
+
+	while (!kthread_should_stop()) {
+		wait_event_interruptible(par->update.wait,
+			fbtft_damage_pending(par) || kthread_should_stop());
+		if (kthread_should_stop())
+			break;
+		fbtft_update_pace(par);
+		if (kthread_should_stop())
+			break;
+		fbtft_flush_damage(par);
+	}
 
-	/* Schedule deferred_io to update display (no-op if already on queue)*/
-	schedule_delayed_work(&info->deferred_work, fbdefio->delay);
+	return 0;
 }
 
 void fbtft_deferred_io(struct fb_info *info, struct list_head *pagelist)
 {
 	struct fbtft_par *par = info->par;
-	unsigned dirty_lines_start, dirty_lines_end;
 	struct page *page;
 	unsigned long index;
 	unsigned y_low = 0, y_high = 0;
 	int count = 0;
-
-	spin_lock(&par->dirty_lock);
-	dirty_lines_start = par->dirty_lines_start;
-	dirty_lines_end = par->dirty_lines_end;
-	/* set display line markers as clean */
-	par->dirty_lines_start = par->info->var.yres - 1;
-	par->dirty_lines_end = 0;
-	spin_unlock(&par->dirty_lock);
+	bool use_worker;
 
 	/* Mark display lines as dirty */
+	spin_lock(&par->dirty_lock);
 	list_for_each_entry(page, pagelist, lru) {
 		count++;
 		index = page->index << PAGE_SHIFT;
@@ -494,41 +1373,223 @@ void fbtft_deferred_io(struct fb_info *info, struct list_head *pagelist)
 		fbtft_dev_dbg(DEBUG_DEFERRED_IO, par, info->device,
 			"page->index=%lu y_low=%d y_high=%d\n",
 			page->index, y_low, y_high);
-		if (y_high > info->var.yres - 1)
-			y_high = info->var.yres - 1;
-		if (y_low < dirty_lines_start)
-			dirty_lines_start = y_low;
-		if (y_high > dirty_lines_end)
-			dirty_lines_end = y_high;
+		/* a page spans whole lines */
+		fbtft_mark_dirty(par, 0, y_low, info->var.xres - 1, y_high);
 	}
+	fbtft_dev_dbg(DEBUG_DEFERRED_IO, par, info->device,
+		"%s: %d pages, %u windows\n", __func__, count,
+		par->damage->num);
+	use_worker = par->update.thread != NULL;
+	if (use_worker)
+		wake_up(&par->update.wait);
+	spin_unlock(&par->dirty_lock);
+
+	if (!use_worker)
+		fbtft_flush_damage(par);
+}
+
+/**
+ * fbtft_set_fps() - Set the display update rate
+ * @par: Driver data
+ * @fps: Frames per second, 0 for as fast as the bus allows
+ *
+ * The update worker paces updates with a high resolution timer.
+ * Deferred io can only wait whole jiffies, so it collects damage at the
+ * nearest shorter interval and without the worker that is the update rate.
+ */
+void fbtft_set_fps(struct fbtft_par *par, unsigned fps)
+{
+	struct fb_deferred_io *fbdefio = par->info->fbdefio;
+
+	par->update.fps = fps;
+	par->update.period = fps ? NSEC_PER_SEC / fps : 0;
+	par->update.target = max(par->update.period, par->update.duration);
+	fbdefio->delay = fps ? HZ / fps : 0;
+	if (!fbdefio->delay)
+		fbdefio->delay = 1;
+}
+EXPORT_SYMBOL(fbtft_set_fps);
+
+/**
+ * fbtft_worker_set_sched() - Set scheduling of the update worker
+ * @par: Driver data
+ * @prio: SCHED_FIFO priority, 0 for SCHED_NORMAL
+ * @cpu: CPU to run on, -1 for any
+ *
+ * Return: 0 if successful, negative if error
+ */
+int fbtft_worker_set_sched(struct fbtft_par *par, int prio, int cpu)
+{
+	struct sched_param param = { .sched_priority = prio };
+	int ret;
+
+	if (prio < 0 || prio >= MAX_USER_RT_PRIO)
+		return -EINVAL;
+	if (cpu >= 0 && (cpu >= nr_cpu_ids || !cpu_online(cpu)))
+		return -EINVAL;
+	if (cpu < 0)
+		cpu = -1;
+
+	par->update.prio = prio;
+	par->update.cpu = cpu;
+	if (!par->update.thread)
+		return 0;
+
+	ret = sched_setscheduler(par->update.thread,
+				prio ? SCHED_FIFO : SCHED_NORMAL, &param);
+	if (ret)
+		return ret;
+
+	return set_cpus_allowed_ptr(par->update.thread,
+			cpu < 0 ? cpu_possible_mask : cpumask_of(cpu));
+}
+EXPORT_SYMBOL(fbtft_worker_set_sched);
+
+static int fbtft_worker_start(struct fbtft_par *par)
+{
+	struct task_struct *thread;
+	int ret;
+
+	thread = kthread_create(fbtft_update_thread, par, "fbtft%d",
+							par->info->node);
+	if (IS_ERR(thread))
+		return PTR_ERR(thread);
+
+	spin_lock(&par->dirty_lock);
+	par->update.thread = thread;
+	spin_unlock(&par->dirty_lock);
+
+	ret = fbtft_worker_set_sched(par, par->update.prio, par->update.cpu);
+	if (ret)
+		dev_warn(par->info->device,
+			"%s: failed to set worker priority=%d cpu=%d (%d)\n",
+			__func__, par->update.prio, par->update.cpu, ret);
+	wake_up_process(thread);
+
+	return 0;
+}
+
+static void fbtft_worker_stop(struct fbtft_par *par)
+{
+	struct task_struct *thread;
+
+	/* deferred io must not wake it once it's gone */
+	spin_lock(&par->dirty_lock);
+	thread = par->update.thread;
+	par->update.thread = NULL;
+	spin_unlock(&par->dirty_lock);
+
+	if (thread)
+		kthread_stop(thread);
+}
+
+
+/*
+ * Translates a window in video memory to display lines if it lies
+ * within the front buffer.
+ */
+static bool fbtft_accel_visible(struct fbtft_par *par, u32 x, u32 *y,
+				u32 width, u32 height)
+{
+	struct fb_info *info = par->info;
+	u32 front = par->update.yoffset;
+
+	if (!width || !height || x + width > info->var.xres ||
+	    *y < front || *y + height > front + info->var.yres)
+		return false;
+	*y -= front;
 
-	par->fbtftops.update_display(info->par,
-					dirty_lines_start, dirty_lines_end);
+	return true;
 }
 
+/*
+ * Queues a drawing operation for the controller. Queued operations run
+ * at the start of the next update, before the damage list is sent, so
+ * the display ends up matching video memory. Returns false if the area
+ * has to be marked dirty instead.
+ */
+static bool fbtft_accel_queue(struct fbtft_par *par, struct fbtft_accel *op)
+{
+	struct fb_copyarea *area = &op->copy;
+	struct fbtft_rect *rect;
+	bool queued = false;
+	unsigned i;
+
+	/* the shadow frame wouldn't know about it */
+	if (par->shadow.buf)
+		return false;
+
+	spin_lock(&par->dirty_lock);
+	if (par->accel.num == FBTFT_ACCEL_MAX)
+		goto out;
+
+	/* the controller copies what is on the display, which is stale */
+	if (op->is_copy) {
+		for (i = 0; i < par->damage->num; i++) {
+			rect = &par->damage->rect[i];
+			if (area->sx <= rect->xe &&
+			    area->sx + area->width - 1 >= rect->xs &&
+			    area->sy <= rect->ye &&
+			    area->sy + area->height - 1 >= rect->ys)
+				goto out;
+		}
+	}
+
+	par->accel.op[par->accel.num++] = *op;
+	queued = true;
+out:
+	spin_unlock(&par->dirty_lock);
+	if (queued)
+		fbtft_update_schedule(par);
+
+	return queued;
+}
 
 void fbtft_fb_fillrect(struct fb_info *info, const struct fb_fillrect *rect)
 {
 	struct fbtft_par *par = info->par;
+	struct fbtft_accel op = { .is_copy = false, .fill = *rect };
 
 	fbtft_dev_dbg(DEBUG_FB_FILLRECT, par, info->dev,
 		"%s: dx=%d, dy=%d, width=%d, height=%d\n",
 		__func__, rect->dx, rect->dy, rect->width, rect->height);
 	sys_fillrect(info, rect);
 
-	par->fbtftops.mkdirty(info, rect->dy, rect->height);
+	if (par->fbtftops.fillrect && rect->rop == ROP_COPY &&
+	    rect->color < ARRAY_SIZE(par->pseudo_palette) &&
+	    fbtft_accel_visible(par, rect->dx, &op.fill.dy,
+				rect->width, rect->height)) {
+		op.fill.color = par->pseudo_palette[rect->color];
+		if (par->bigendian)
+			op.fill.color = swab16(op.fill.color);
+		if (fbtft_accel_queue(par, &op))
+			return;
+	}
+
+	par->fbtftops.mkdirty(info, rect->dx, rect->dy,
+				rect->width, rect->height);
 }
 
 void fbtft_fb_copyarea(struct fb_info *info, const struct fb_copyarea *area)
 {
 	struct fbtft_par *par = info->par;
+	struct fbtft_accel op = { .is_copy = true, .copy = *area };
 
 	fbtft_dev_dbg(DEBUG_FB_COPYAREA, par, info->dev,
 		"%s: dx=%d, dy=%d, width=%d, height=%d\n",
 		__func__,  area->dx, area->dy, area->width, area->height);
 	sys_copyarea(info, area);
 
-	par->fbtftops.mkdirty(info, area->dy, area->height);
+	if (par->fbtftops.copyarea &&
+	    fbtft_accel_visible(par, area->sx, &op.copy.sy,
+				area->width, area->height) &&
+	    fbtft_accel_visible(par, area->dx, &op.copy.dy,
+				area->width, area->height) &&
+	    fbtft_accel_queue(par, &op))
+		return;
+
+	par->fbtftops.mkdirty(info, area->dx, area->dy,
+				area->width, area->height);
 }
 
 void fbtft_fb_imageblit(struct fb_info *info, const struct fb_image *image)
@@ -540,7 +1601,41 @@ void fbtft_fb_imageblit(struct fb_info *info, const struct fb_image *image)
 		__func__,  image->dx, image->dy, image->width, image->height);
 	sys_imageblit(info, image);
 
-	par->fbtftops.mkdirty(info, image->dy, image->height);
+	par->fbtftops.mkdirty(info, image->dx, image->dy,
+				image->width, image->height);
+}
+
+/* Marks the pixels covered by len bytes of video memory at offset */
+static void fbtft_mkdirty_span(struct fb_info *info, unsigned long offset,
+			       size_t len)
+{
+	struct fbtft_par *par = info->par;
+	unsigned line_length = info->fix.line_length;
+	unsigned bpp = info->var.bits_per_pixel;
+	unsigned long end = offset + len - 1;
+	unsigned ys = offset / line_length;
+	unsigned ye = end / line_length;
+	unsigned xs = (offset % line_length) * 8 / bpp;
+	unsigned xe = (end % line_length) * 8 / bpp;
+	unsigned xres = info->var.xres;
+
+	if (ys >= info->var.yres_virtual)
+		return;
+	if (ye >= info->var.yres_virtual) {
+		ye = info->var.yres_virtual - 1;
+		xe = xres - 1;
+	}
+
+	if (ys == ye) {
+		par->fbtftops.mkdirty(info, xs, ys, xe - xs + 1, 1);
+		return;
+	}
+
+	/* partial first line, whole lines in between, partial last line */
+	par->fbtftops.mkdirty(info, xs, ys, xres - xs, 1);
+	if (ye - ys > 1)
+		par->fbtftops.mkdirty(info, 0, ys + 1, xres, ye - ys - 1);
+	par->fbtftops.mkdirty(info, 0, ye, xe + 1, 1);
 }
 
 ssize_t fbtft_fb_write(struct fb_info *info,
@@ -552,14 +1647,134 @@ ssize_t fbtft_fb_write(struct fb_info *info,
 	fbtft_dev_dbg(DEBUG_FB_WRITE, par, info->dev,
 		"%s: count=%zd, ppos=%llu\n", __func__,  count, *ppos);
 	res = fb_sys_write(info, buf, count, ppos);
-
-	/* TODO: only mark changed area
-	   update all for now */
-	par->fbtftops.mkdirty(info, -1, 0);
+	if (res > 0)
+		fbtft_mkdirty_span(info, *ppos - res, res);
 
 	return res;
 }
 
+/*
+ * Flips to another frame in video memory. The whole new front buffer is
+ * pushed right away, so the application can render into the old one
+ * while it is transferred.
+ */
+static int fbtft_fb_pan_display(struct fb_var_screeninfo *var,
+				struct fb_info *info)
+{
+	struct fbtft_par *par = info->par;
+	bool use_worker;
+
+	fbtft_dev_dbg(DEBUG_FB_IOCTL, par, info->dev,
+		"%s: xoffset=%u, yoffset=%u\n", __func__,
+		var->xoffset, var->yoffset);
+
+	/*
+	 * fbcon scrolling: video memory lines map to the same frame memory
+	 * lines, only the controller's scroll position changes. Can be
+	 * called from atomic context, so the update worker sets it.
+	 */
+	if (var->vmode & FB_VMODE_YWRAP) {
+		if (!info->fix.ywrapstep || var->xoffset ||
+		    var->yoffset >= info->var.yres_virtual)
+			return -EINVAL;
+		spin_lock(&par->dirty_lock);
+		par->update.scroll = var->yoffset;
+		spin_unlock(&par->dirty_lock);
+		fbtft_update_schedule(par);
+		return 0;
+	}
+
+	if (var->xoffset ||
+	    var->yoffset + info->var.yres > info->var.yres_virtual)
+		return -EINVAL;
+
+	spin_lock(&par->dirty_lock);
+	par->update.yoffset = var->yoffset;
+	par->update.now = true;
+	par->damage->num = 0;
+	fbtft_damage_add(par, par->damage, 0, 0,
+			info->var.xres - 1, info->var.yres - 1);
+	use_worker = par->update.thread != NULL;
+	if (use_worker)
+		wake_up(&par->update.wait);
+	spin_unlock(&par->dirty_lock);
+
+	if (!use_worker)
+		mod_delayed_work(system_wq, &info->deferred_work, 0);
+
+	return 0;
+}
+
+/* Adds the rectangles to the damage list and updates the display */
+static int fbtft_flush_rects(struct fbtft_par *par,
+			     struct fbtft_flush __user *argp)
+{
+	struct fb_info *info = par->info;
+	struct fbtft_flush flush;
+	unsigned xres = info->var.xres;
+	unsigned yres = info->var.yres;
+	unsigned x, y, w, h;
+	unsigned i;
+
+	if (copy_from_user(&flush, argp, sizeof(flush)))
+		return -EFAULT;
+	if (flush.version != FBTFT_FLUSH_VERSION || flush.num > FBTFT_FLUSH_MAX)
+		return -EINVAL;
+
+	spin_lock(&par->dirty_lock);
+	for (i = 0; i < flush.num; i++) {
+		x = flush.rect[i].x;
+		y = flush.rect[i].y;
+		w = flush.rect[i].width;
+		h = flush.rect[i].height;
+		if (!w || !h || x >= xres || y >= yres)
+			continue;
+		w = min(w, xres - x);
+		h = min(h, yres - y);
+		fbtft_damage_add(par, par->damage, x, y, x + w - 1, y + h - 1);
+	}
+	spin_unlock(&par->dirty_lock);
+
+	fbtft_flush_damage(par);
+
+	return 0;
+}
+
+static int fbtft_fb_ioctl(struct fb_info *info, unsigned int cmd,
+			  unsigned long arg)
+{
+	struct fbtft_par *par = info->par;
+	u32 crtc;
+
+	fbtft_dev_dbg(DEBUG_FB_IOCTL, par, info->dev,
+		"%s: cmd=0x%x, arg=0x%lx\n", __func__, cmd, arg);
+
+	switch (cmd) {
+	case FBTFT_IOCTL_FLUSH:
+		return fbtft_flush_rects(par, (void __user *)arg);
+	case FBIO_WAITFORVSYNC:
+		if (get_user(crtc, (u32 __user *)arg))
+			return -EFAULT;
+		if (crtc != 0)
+			return -ENODEV;
+		return fbtft_wait_for_push(par);
+	}
+
+	return -ENOTTY;
+}
+
+static int fbtft_fb_mmap(struct fb_info *info, struct vm_area_struct *vma)
+{
+	struct fbtft_par *par = info->par;
+
+	if (!par->manual)
+		return par->defio_mmap(info, vma);
+
+	/* no page fault tracking, userspace flushes with FBTFT_IOCTL_FLUSH */
+	return remap_vmalloc_range(vma, (void __force *)info->screen_base,
+				   vma->vm_pgoff);
+}
+
 /* from pxafb.c */
 unsigned int chan_to_field(unsigned chan, struct fb_bitfield *bf)
 {
@@ -588,6 +1803,8 @@ int fbtft_fb_setcolreg(unsigned regno,
 			val  = chan_to_field(red,   &info->var.red);
 			val |= chan_to_field(green, &info->var.green);
 			val |= chan_to_field(blue,  &info->var.blue);
+			if (par->bigendian)
+				val = swab16(val);
 
 			pal[regno] = val;
 			ret = 0;
@@ -609,6 +1826,8 @@ int fbtft_fb_blank(int blank, struct fb_info *info)
 	if (!par->fbtftops.blank)
 		return ret;
 
+	/* keep the register writes out of an update in progress */
+	mutex_lock(&par->update.lock);
 	switch (blank) {
 	case FB_BLANK_POWERDOWN:
 	case FB_BLANK_VSYNC_SUSPEND:
@@ -620,9 +1839,49 @@ int fbtft_fb_blank(int blank, struct fb_info *info)
 		ret = par->fbtftops.blank(par, false);
 		break;
 	}
+	fbtft_addr_win_invalidate(par);
+	mutex_unlock(&par->update.lock);
+
 	return ret;
 }
 
+/*
+ * write_register_buf() for drivers that only have their own varargs
+ * write_register().
+ */
+static void fbtft_write_register_buf(struct fbtft_par *par, const u16 *vals,
+				     int len)
+{
+	u16 buf[FBTFT_MAX_REG_VALUES] = { 0 };
+
+	if (len <= 0)
+		return;
+	if (len > FBTFT_MAX_REG_VALUES) {
+		dev_err(par->info->device,
+			"%s: Maximum register values exceeded\n", __func__);
+		return;
+	}
+	memcpy(buf, vals, len * sizeof(*vals));
+
+	par->fbtftops.write_register(par, len,
+		buf[0], buf[1], buf[2], buf[3],
+		buf[4], buf[5], buf[6], buf[7],
+		buf[8], buf[9], buf[10], buf[11],
+		buf[12], buf[13], buf[14], buf[15],
+		buf[16], buf[17], buf[18], buf[19],
+		buf[20], buf[21], buf[22], buf[23],
+		buf[24], buf[25], buf[26], buf[27],
+		buf[28], buf[29], buf[30], buf[31],
+		buf[32], buf[33], buf[34], buf[35],
+		buf[36], buf[37], buf[38], buf[39],
+		buf[40], buf[41], buf[42], buf[43],
+		buf[44], buf[45], buf[46], buf[47],
+		buf[48], buf[49], buf[50], buf[51],
+		buf[52], buf[53], buf[54], buf[55],
+		buf[56], buf[57], buf[58], buf[59],
+		buf[60], buf[61], buf[62], buf[63]);
+}
+
 void fbtft_merge_fbtftops(struct fbtft_ops *dst, struct fbtft_ops *src)
 {
 	if (src->write)
@@ -631,8 +1890,14 @@ void fbtft_merge_fbtftops(struct fbtft_ops *dst, struct fbtft_ops *src)
 		dst->read = src->read;
 	if (src->write_vmem)
 		dst->write_vmem = src->write_vmem;
-	if (src->write_register)
+	if (src->write_register) {
 		dst->write_register = src->write_register;
+		/* the default one would bypass it */
+		dst->write_register_buf = src->write_register_buf ?:
+					  fbtft_write_register_buf;
+	}
+	if (src->write_register_buf)
+		dst->write_register_buf = src->write_register_buf;
 	if (src->set_addr_win)
 		dst->set_addr_win = src->set_addr_win;
 	if (src->reset)
@@ -659,6 +1924,12 @@ void fbtft_merge_fbtftops(struct fbtft_ops *dst, struct fbtft_ops *src)
 		dst->set_var = src->set_var;
 	if (src->set_gamma)
 		dst->set_gamma = src->set_gamma;
+	if (src->set_scroll)
+		dst->set_scroll = src->set_scroll;
+	if (src->fillrect)
+		dst->fillrect = src->fillrect;
+	if (src->copyarea)
+		dst->copyarea = src->copyarea;
 }
 
 /**
@@ -679,11 +1950,140 @@ void fbtft_merge_fbtftops(struct fbtft_ops *dst, struct fbtft_ops *src)
  * Returns the new structure, or NULL if an error occurred.
  *
  */
+/*
+ * Can the default write_vmem() send video memory as is?
+ * Big endian RGB565 is what the controllers expect.
+ */
+static bool fbtft_vmem_as_is(struct fbtft_par *par,
+				struct fbtft_display *display, unsigned bpp)
+{
+	if (display->fbtftops.write_vmem || bpp != 16 || par->startbyte)
+		return false;
+	if (display->buswidth == 16)
+		return true;
+#ifdef __BIG_ENDIAN
+	if (display->buswidth == 8)
+		return true;
+#endif
+	return display->buswidth == 8 && (par->bigendian || par->littleendian);
+}
+
+/*
+ * Map video memory page by page for scatter-gather DMA. The pages are
+ * handed to the SPI controller as is, so they are mapped for the device
+ * doing the DMA, the controller's parent. -ENODEV if it can't do DMA,
+ * video memory is copied to the transmit buffer then.
+ */
+static int fbtft_vmem_sg_map(struct fbtft_par *par, struct spi_device *spi,
+								size_t size)
+{
+	struct device *dev = par->info->device;
+	struct device *dma_dev = spi->master->dev.parent;
+	struct sg_table *table = &par->vmem_sg.table;
+	u8 *vmem = (u8 __force *)par->info->screen_base;
+	unsigned npages = DIV_ROUND_UP(size, PAGE_SIZE);
+	struct scatterlist *sg;
+	int i, nents, ret;
+
+	if (!dma_dev || !dma_dev->dma_mask)
+		return -ENODEV;
+
+	par->vmem_sg.xfer = devm_kcalloc(dev, npages,
+				sizeof(struct spi_transfer), GFP_KERNEL);
+	if (!par->vmem_sg.xfer)
+		return -ENOMEM;
+
+	ret = sg_alloc_table(table, npages, GFP_KERNEL);
+	if (ret)
+		return ret;
+
+	for_each_sg(table->sgl, sg, npages, i)
+		sg_set_page(sg, vmalloc_to_page(vmem + i * PAGE_SIZE),
+			    min_t(size_t, size - i * PAGE_SIZE, PAGE_SIZE), 0);
+
+	nents = dma_map_sg(dma_dev, table->sgl, table->nents, DMA_TO_DEVICE);
+	if (!nents) {
+		sg_free_table(table);
+		return -ENOMEM;
+	}
+	par->vmem_sg.dev = dma_dev;
+	par->vmem_sg.nents = nents;
+
+	return 0;
+}
+
+/* Transmit buffer, DMA mapped if enabled */
+static void *fbtft_txbuf_alloc(struct device *dev, size_t len,
+							dma_addr_t *handle)
+{
+	void *buf;
+
+	if (!dma)
+		return devm_kzalloc(dev, len, GFP_KERNEL);
+
+	dev->coherent_dma_mask = ~0;
+	if (!streaming)
+		return dmam_alloc_coherent(dev, len, handle, GFP_DMA);
+
+	/*
+	 * cached, so conversion doesn't do uncached stores. Whole cache lines
+	 * so syncing can't clobber a neighbouring allocation.
+	 */
+	buf = kzalloc(ALIGN(len, dma_get_cache_alignment()),
+		      GFP_KERNEL | GFP_DMA);
+	if (!buf)
+		return NULL;
+
+	if (!dev->dma_mask)
+		dev->dma_mask = &dev->coherent_dma_mask;
+	*handle = dma_map_single(dev, buf, len, DMA_TO_DEVICE);
+	if (dma_mapping_error(dev, *handle)) {
+		dev_warn(dev, "failed to map transmit buffer for DMA\n");
+		*handle = 0;
+	}
+
+	return buf;
+}
+
+/* Unmaps and frees streaming transmit buffers, the others are managed */
+static void fbtft_txbuf_free(struct fbtft_par *par)
+{
+	struct device *dev = par->info->device;
+
+	if (!par->txbuf.streaming)
+		return;
+
+	if (par->txbuf.dma)
+		dma_unmap_single(dev, par->txbuf.dma, par->txbuf.len,
+							DMA_TO_DEVICE);
+	if (par->pipe[1].buf && par->pipe[1].dma)
+		dma_unmap_single(dev, par->pipe[1].dma, par->txbuf.len,
+							DMA_TO_DEVICE);
+	kfree(par->txbuf.buf);
+	kfree(par->pipe[1].buf);
+	par->txbuf.buf = NULL;
+	par->pipe[0].buf = NULL;
+	par->pipe[1].buf = NULL;
+}
+
+static void fbtft_vmem_sg_unmap(struct fbtft_par *par)
+{
+	struct sg_table *table = &par->vmem_sg.table;
+
+	if (!par->vmem_sg.nents)
+		return;
+
+	dma_unmap_sg(par->vmem_sg.dev, table->sgl, table->nents,
+							DMA_TO_DEVICE);
+	sg_free_table(table);
+	par->vmem_sg.nents = 0;
+}
+
 struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 					struct device *dev)
 {
 	struct fb_info *info;
-	struct fbtft_par *par;
+	struct fbtft_par *par = NULL;
 	struct fb_ops *fbops = NULL;
 	struct fb_deferred_io *fbdefio = NULL;
 	struct fbtft_platform_data *pdata = dev->platform_data;
@@ -695,7 +2095,11 @@ struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 	int txbuflen = display->txbuflen;
 	unsigned bpp = display->bpp;
 	unsigned fps = display->fps;
-	int vmem_size, i;
+	int frame_size, vmem_size, i, ret;
+	unsigned nframes = frames;
+	bool hwscroll;
+	bool be565 = false;
+	bool le565 = false;
 	int *init_sequence = display->init_sequence;
 	char *gamma = display->gamma;
 	unsigned long *gamma_curves = NULL;
@@ -755,8 +2159,45 @@ struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 		height = display->height;
 	}
 
-	vmem_size = display->width * display->height * bpp / 8;
-	vmem = vzalloc(vmem_size);
+	if (frames < 1 || frames > 3) {
+		dev_err(dev, "frames=%u is out of range (1-3)\n", frames);
+		return NULL;
+	}
+
+	/* the scroll axis must be the controller's */
+	hwscroll = vscroll && display->fbtftops.set_scroll &&
+		   (pdata->rotate == 0 || pdata->rotate == 180);
+	if (hwscroll)
+		nframes = 1;
+
+#ifdef __LITTLE_ENDIAN
+	/* only the default 8-bit bus write_vmem() knows about it */
+	if (bigendian || pdata->bigendian) {
+		if (bpp == 16 && display->buswidth == 8 &&
+		    !display->fbtftops.write_vmem)
+			be565 = true;
+		else
+			dev_warn(dev, "big endian video memory is not supported by this display, ignoring\n");
+	}
+	/*
+	 * Only on the parallel MCU interface. On SPI the controllers take
+	 * words MSB first regardless, so the swap stays.
+	 */
+	if ((littleendian || pdata->littleendian) && !be565) {
+		if (dev->bus != &platform_bus_type)
+			dev_warn(dev, "little endian interface is not supported on SPI, ignoring\n");
+		else if (bpp == 16 && display->buswidth == 8 &&
+			 !display->fbtftops.write_vmem &&
+			 (display->caps & FBTFT_CAP_LITTLE_ENDIAN))
+			le565 = true;
+		else
+			dev_warn(dev, "little endian interface is not supported by this display, ignoring\n");
+	}
+#endif
+
+	frame_size = display->width * display->height * bpp / 8;
+	vmem_size = frame_size * nframes;
+	vmem = vmalloc_user(vmem_size);
 	if (!vmem)
 		goto alloc_fail;
 
@@ -795,8 +2236,9 @@ struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 	fbops->fb_imageblit =      fbtft_fb_imageblit;
 	fbops->fb_setcolreg =      fbtft_fb_setcolreg;
 	fbops->fb_blank     =      fbtft_fb_blank;
+	fbops->fb_ioctl     =      fbtft_fb_ioctl;
+	fbops->fb_pan_display =    fbtft_fb_pan_display;
 
-	fbdefio->delay =           HZ/fps;
 	fbdefio->deferred_io =     fbtft_deferred_io;
 	fb_deferred_io_init(info);
 
@@ -804,8 +2246,8 @@ struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 	info->fix.type =           FB_TYPE_PACKED_PIXELS;
 	info->fix.visual =         FB_VISUAL_TRUECOLOR;
 	info->fix.xpanstep =	   0;
-	info->fix.ypanstep =	   0;
-	info->fix.ywrapstep =	   0;
+	info->fix.ypanstep =	   nframes > 1 ? 1 : 0;
+	info->fix.ywrapstep =	   hwscroll ? 1 : 0;
 	info->fix.line_length =    width*bpp/8;
 	info->fix.accel =          FB_ACCEL_NONE;
 	info->fix.smem_len =       vmem_size;
@@ -814,9 +2256,9 @@ struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 	info->var.xres =           width;
 	info->var.yres =           height;
 	info->var.xres_virtual =   info->var.xres;
-	info->var.yres_virtual =   info->var.yres;
+	info->var.yres_virtual =   info->var.yres * nframes;
 	info->var.bits_per_pixel = bpp;
-	info->var.nonstd =         1;
+	info->var.nonstd =         be565 ? FBTFT_NONSTD_BE565 : 1;
 
 	/* RGB565 */
 	info->var.red.offset =     11;
@@ -829,6 +2271,8 @@ struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 	info->var.transp.length =  0;
 
 	info->flags =              FBINFO_FLAG_DEFAULT | FBINFO_VIRTFB;
+	if (hwscroll)
+		info->flags |= FBINFO_HWACCEL_YWRAP | FBINFO_READS_FAST;
 
 	par = info->par;
 	par->info = info;
@@ -836,7 +2280,24 @@ struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 	par->debug = display->debug;
 	par->buf = buf;
 	spin_lock_init(&par->dirty_lock);
+	mutex_init(&par->update.lock);
+	init_waitqueue_head(&par->update.wait);
+	init_waitqueue_head(&par->update.push_wait);
+	par->update.prio = worker_prio;
+	par->update.cpu = worker_cpu;
+	par->update.scroll = -1;
+	par->accel.op = par->accel.buf[0];
+	par->damage = &par->damage_buf[0];
+	fbtft_addr_win_invalidate(par);
+	fbtft_set_fps(par, pace ? fps : 0);
+	par->manual = manual;
+	/* fb_deferred_io_init() installed its own */
+	par->defio_mmap = fbops->fb_mmap;
+	fbops->fb_mmap = fbtft_fb_mmap;
+	par->caps = display->caps;
 	par->bgr = pdata->bgr;
+	par->bigendian = be565;
+	par->littleendian = le565;
 	par->startbyte = pdata->startbyte;
 	par->init_sequence = init_sequence;
 	par->gamma.curves = gamma_curves;
@@ -851,28 +2312,59 @@ struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 			goto alloc_fail;
 	}
 
+	if (dma && zerocopy && dev->bus == &spi_bus_type &&
+	    fbtft_vmem_as_is(par, display, bpp)) {
+		ret = fbtft_vmem_sg_map(par, to_spi_device(dev), vmem_size);
+		if (ret && ret != -ENODEV)
+			dev_warn(dev, "failed to map video memory for DMA\n");
+	}
+
 	/* Transmit buffer */
+	if (txbuflen == -1 && par->vmem_sg.nents)
+		txbuflen = 0; /* video memory is sent without a bounce buffer */
 	if (txbuflen == -1)
-		txbuflen = vmem_size + 2; /* add in case startbyte is used */
+		txbuflen = frame_size + 2; /* add in case startbyte is used */
+
+	/* keep the driver's transfer size, but queue a frame at once */
+	if (chain && txbuflen > 0 && txbuflen < frame_size) {
+		par->chain.chunk = txbuflen;
+		par->chain.num = DIV_ROUND_UP(frame_size + 2, txbuflen);
+		par->chain.xfer = devm_kcalloc(dev, par->chain.num,
+				sizeof(struct spi_transfer), GFP_KERNEL);
+		if (!par->chain.xfer)
+			goto alloc_fail;
+		txbuflen = frame_size + 2;
+	}
 
 #ifdef __LITTLE_ENDIAN
 	if ((!txbuflen) && (bpp > 8))
 		txbuflen = PAGE_SIZE; /* need buffer for byteswapping */
 #endif
 
+	par->txbuf.streaming = dma && streaming;
 	if (txbuflen > 0) {
-		if (dma) {
-			dev->coherent_dma_mask = ~0;
-			txbuf = dmam_alloc_coherent(dev, txbuflen, &par->txbuf.dma, GFP_DMA);
-		} else {
-			txbuf = devm_kzalloc(par->info->device, txbuflen, GFP_KERNEL);
-		}
+		txbuf = fbtft_txbuf_alloc(dev, txbuflen, &par->txbuf.dma);
 		if (!txbuf)
 			goto alloc_fail;
 		par->txbuf.buf = txbuf;
 		par->txbuf.len = txbuflen;
 	}
 
+	/* Second transmit buffer for pipelined transfers */
+	if (txbuf && pipeline && txbuflen < frame_size) {
+		txbuf = fbtft_txbuf_alloc(dev, txbuflen, &par->pipe[1].dma);
+		if (txbuf) {
+			par->pipe[0].buf = par->txbuf.buf;
+			par->pipe[0].dma = par->txbuf.dma;
+			par->pipe[1].buf = txbuf;
+		} else {
+			dev_warn(dev, "no memory for a second transmit buffer, not pipelining\n");
+		}
+	}
+	for (i = 0; i < FBTFT_PIPE_DEPTH; i++)
+		init_completion(&par->pipe[i].done);
+	init_completion(&par->te.done);
+
 	/* Initialize gpios to disabled */
 	par->gpio.reset = -1;
 	par->gpio.dc = -1;
@@ -880,6 +2372,7 @@ struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 	par->gpio.wr = -1;
 	par->gpio.cs = -1;
 	par->gpio.latch = -1;
+	par->gpio.te = -1;
 	for (i = 0; i < 16; i++) {
 		par->gpio.db[i] = -1;
 		par->gpio.led[i] = -1;
@@ -891,6 +2384,7 @@ struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 	par->fbtftops.read = fbtft_read_spi;
 	par->fbtftops.write_vmem = fbtft_write_vmem16_bus8;
 	par->fbtftops.write_register = fbtft_write_reg8_bus8;
+	par->fbtftops.write_register_buf = fbtft_write_reg8_bus8_buf;
 	par->fbtftops.set_addr_win = fbtft_set_addr_win;
 	par->fbtftops.reset = fbtft_reset;
 	par->fbtftops.mkdirty = fbtft_mkdirty;
@@ -905,6 +2399,10 @@ struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 	return info;
 
 alloc_fail:
+	if (par) {
+		fbtft_vmem_sg_unmap(par);
+		fbtft_txbuf_free(par);
+	}
 	vfree(vmem);
 
 	return NULL;
@@ -919,7 +2417,12 @@ EXPORT_SYMBOL(fbtft_framebuffer_alloc);
  */
 void fbtft_framebuffer_release(struct fb_info *info)
 {
+	struct fbtft_par *par = info->par;
+
 	fb_deferred_io_cleanup(info);
+	fbtft_vmem_sg_unmap(par);
+	fbtft_txbuf_free(par);
+	vfree(par->shadow.buf);
 	vfree(info->screen_base);
 	framebuffer_release(info);
 }
@@ -967,6 +2470,10 @@ int fbtft_register_framebuffer(struct fb_info *fb_info)
 			goto reg_fail;
 	}
 
+	if (cmdq)
+		fbtft_cmdq_init(par);
+
+	fbtft_addr_win_invalidate(par);
 	ret = par->fbtftops.init_display(par);
 	if (ret < 0)
 		goto reg_fail;
@@ -974,10 +2481,28 @@ int fbtft_register_framebuffer(struct fb_info *fb_info)
 		ret = par->fbtftops.set_var(par);
 		if (ret < 0)
 			goto reg_fail;
+		/* the window may have been written in the old orientation */
+		fbtft_addr_win_invalidate(par);
 	}
 
+	ret = fbtft_te_init(par);
+	if (ret)
+		dev_warn(fb_info->device,
+			"tearing effect sync not available (%d)\n", ret);
+
+	if (benchmark)
+		fbtft_benchmark_conversion(par);
+
 	/* update the entire display */
-	par->fbtftops.update_display(par, 0, par->info->var.yres - 1);
+	par->fbtftops.update_display(par, 0, 0, par->info->var.xres - 1,
+					par->info->var.yres - 1);
+
+	/* the display now matches video memory */
+	if (shadow) {
+		ret = fbtft_shadow_alloc(par);
+		if (ret)
+			goto reg_fail;
+	}
 
 	if (par->fbtftops.set_gamma && par->gamma.curves) {
 		ret = par->fbtftops.set_gamma(par, par->gamma.curves);
@@ -988,12 +2513,25 @@ int fbtft_register_framebuffer(struct fb_info *fb_info)
 	if (par->fbtftops.register_backlight)
 		par->fbtftops.register_backlight(par);
 
+	if (par->fbtftops.fillrect)
+		fb_info->flags |= FBINFO_HWACCEL_FILLRECT;
+	if (par->fbtftops.copyarea)
+		fb_info->flags |= FBINFO_HWACCEL_COPYAREA;
+
 	ret = register_framebuffer(fb_info);
 	if (ret < 0)
 		goto reg_fail;
 
 	fbtft_sysfs_init(par);
 
+	if (worker) {
+		ret = fbtft_worker_start(par);
+		if (ret)
+			dev_warn(fb_info->device,
+				"failed to start update worker (%d), updating from deferred io\n",
+				ret);
+	}
+
 	if (par->txbuf.buf)
 		sprintf(text1, ", %d KiB %sbuffer memory",
 			par->txbuf.len >> 10, par->txbuf.dma ? "DMA " : "");
@@ -1001,10 +2539,10 @@ int fbtft_register_framebuffer(struct fb_info *fb_info)
 		sprintf(text2, ", spi%d.%d at %d MHz", spi->master->bus_num,
 				spi->chip_select, spi->max_speed_hz/1000000);
 	dev_info(fb_info->dev,
-		"%s frame buffer, %dx%d, %d KiB video memory%s, fps=%lu%s\n",
+		"%s frame buffer, %dx%d, %d KiB video memory%s, fps=%u%s\n",
 		fb_info->fix.id, fb_info->var.xres, fb_info->var.yres,
 		fb_info->fix.smem_len >> 10, text1,
-		HZ/fb_info->fbdefio->delay, text2);
+		par->update.fps, text2);
 
 #ifdef CONFIG_FB_BACKLIGHT
 	/* Turn on backlight if available */
@@ -1050,6 +2588,9 @@ int fbtft_unregister_framebuffer(struct fb_info *fb_info)
 	if (par->fbtftops.unregister_backlight)
 		par->fbtftops.unregister_backlight(par);
 	fbtft_sysfs_exit(par);
+	fbtft_worker_stop(par);
+	if (par->te.irq)
+		devm_free_irq(fb_info->device, par->te.irq, par);
 	ret = unregister_framebuffer(fb_info);
 	return ret;
 }
@@ -1068,7 +2609,8 @@ static int fbtft_init_display_dt(struct fbtft_par *par)
 	struct property *prop;
 	const __be32 *p;
 	u32 val;
-	int buf[64], i, j;
+	u16 buf[FBTFT_MAX_REG_VALUES];
+	int i, j;
 	char msg[128];
 	char str[16];
 
@@ -1086,7 +2628,7 @@ static int fbtft_init_display_dt(struct fbtft_par *par)
 			val &= 0xFFFF;
 			i = 0;
 			while (p && !(val & 0xFFFF0000)) {
-				if (i > 63) {
+				if (i >= FBTFT_MAX_REG_VALUES) {
 					dev_err(par->info->device,
 					"%s: Maximum register values exceeded\n",
 					__func__);
@@ -1104,23 +2646,7 @@ static int fbtft_init_display_dt(struct fbtft_par *par)
 			fbtft_par_dbg(DEBUG_INIT_DISPLAY, par,
 				"init: write_register:%s\n", msg);
 
-			par->fbtftops.write_register(par, i,
-				buf[0], buf[1], buf[2], buf[3],
-				buf[4], buf[5], buf[6], buf[7],
-				buf[8], buf[9], buf[10], buf[11],
-				buf[12], buf[13], buf[14], buf[15],
-				buf[16], buf[17], buf[18], buf[19],
-				buf[20], buf[21], buf[22], buf[23],
-				buf[24], buf[25], buf[26], buf[27],
-				buf[28], buf[29], buf[30], buf[31],
-				buf[32], buf[33], buf[34], buf[35],
-				buf[36], buf[37], buf[38], buf[39],
-				buf[40], buf[41], buf[42], buf[43],
-				buf[44], buf[45], buf[46], buf[47],
-				buf[48], buf[49], buf[50], buf[51],
-				buf[52], buf[53], buf[54], buf[55],
-				buf[56], buf[57], buf[58], buf[59],
-				buf[60], buf[61], buf[62], buf[63]);
+			par->fbtftops.write_register_buf(par, buf, i);
 		} else if (val & FBTFT_OF_INIT_DELAY) {
 			fbtft_par_dbg(DEBUG_INIT_DISPLAY, par,
 				"init: msleep(%u)\n", val & 0xFFFF);
@@ -1147,11 +2673,12 @@ static int fbtft_init_display_dt(struct fbtft_par *par)
  */
 int fbtft_init_display(struct fbtft_par *par)
 {
-	int buf[64];
+	u16 buf[FBTFT_MAX_REG_VALUES];
 	char msg[128];
 	char str[16];
 	int i = 0;
 	int j;
+	int ret;
 
 	fbtft_par_dbg(DEBUG_INIT_DISPLAY, par, "%s()\n", __func__);
 
@@ -1176,22 +2703,25 @@ int fbtft_init_display(struct fbtft_par *par)
 	if (par->gpio.cs != -1)
 		gpio_set_value(par->gpio.cs, 0);  /* Activate chip */
 
+	/* send the writes between delays at once */
+	fbtft_cmdq_open(par);
+
 	i = 0;
 	while (i < FBTFT_MAX_INIT_SEQUENCE) {
 		if (par->init_sequence[i] == -3) {
 			/* done */
-			return 0;
+			return fbtft_cmdq_submit(par);
 		}
 		if (par->init_sequence[i] >= 0) {
 			dev_err(par->info->device,
 				"missing delimiter at position %d\n", i);
-			return -EINVAL;
+			goto out_einval;
 		}
 		if (par->init_sequence[i+1] < 0) {
 			dev_err(par->info->device,
 				"missing value after delimiter %d at position %d\n",
 				par->init_sequence[i], i);
-			return -EINVAL;
+			goto out_einval;
 		}
 		switch (par->init_sequence[i]) {
 		case -1:
@@ -1211,49 +2741,40 @@ int fbtft_init_display(struct fbtft_par *par)
 			/* Write */
 			j = 0;
 			while (par->init_sequence[i] >= 0) {
-				if (j > 63) {
+				if (j >= FBTFT_MAX_REG_VALUES) {
 					dev_err(par->info->device,
 					"%s: Maximum register values exceeded\n",
 					__func__);
-					return -EINVAL;
+					goto out_einval;
 				}
 				buf[j++] = par->init_sequence[i++];
 			}
-			par->fbtftops.write_register(par, j,
-				buf[0], buf[1], buf[2], buf[3],
-				buf[4], buf[5], buf[6], buf[7],
-				buf[8], buf[9], buf[10], buf[11],
-				buf[12], buf[13], buf[14], buf[15],
-				buf[16], buf[17], buf[18], buf[19],
-				buf[20], buf[21], buf[22], buf[23],
-				buf[24], buf[25], buf[26], buf[27],
-				buf[28], buf[29], buf[30], buf[31],
-				buf[32], buf[33], buf[34], buf[35],
-				buf[36], buf[37], buf[38], buf[39],
-				buf[40], buf[41], buf[42], buf[43],
-				buf[44], buf[45], buf[46], buf[47],
-				buf[48], buf[49], buf[50], buf[51],
-				buf[52], buf[53], buf[54], buf[55],
-				buf[56], buf[57], buf[58], buf[59],
-				buf[60], buf[61], buf[62], buf[63]);
+			par->fbtftops.write_register_buf(par, buf, j);
 			break;
 		case -2:
 			i++;
 			fbtft_par_dbg(DEBUG_INIT_DISPLAY, par,
 				"init: mdelay(%d)\n", par->init_sequence[i]);
+			ret = fbtft_cmdq_flush(par);
+			if (ret < 0)
+				goto out;
 			mdelay(par->init_sequence[i++]);
 			break;
 		default:
 			dev_err(par->info->device,
 				"unknown delimiter %d at position %d\n",
 				par->init_sequence[i], i);
-			return -EINVAL;
+			goto out_einval;
 		}
 	}
 
 	dev_err(par->info->device,
 		"%s: something is wrong. Shouldn't get here.\n", __func__);
-	return -EINVAL;
+out_einval:
+	ret = -EINVAL;
+out:
+	fbtft_cmdq_submit(par);
+	return ret;
 }
 EXPORT_SYMBOL(fbtft_init_display);
 
@@ -1335,6 +2856,8 @@ static struct fbtft_platform_data *fbtft_probe_dt(struct device *dev)
 	pdata->display.debug = fbtft_of_value(node, "debug");
 	pdata->rotate = fbtft_of_value(node, "rotate");
 	pdata->bgr = of_property_read_bool(node, "bgr");
+	pdata->bigendian = of_property_read_bool(node, "bigendian");
+	pdata->littleendian = of_property_read_bool(node, "littleendian");
 	pdata->fps = fbtft_of_value(node, "fps");
 	pdata->txbuflen = fbtft_of_value(node, "txbuflen");
 	pdata->startbyte = fbtft_of_value(node, "startbyte");
@@ -1356,6 +2879,41 @@ static struct fbtft_platform_data *fbtft_probe_dt(struct device *dev)
 }
 #endif
 
+/*
+ * 16-bit SPI words go out MSB first from native endian memory, so the
+ * master does the RGB565 byteswap. Only pixel transfers use them.
+ */
+static int fbtft_spi16_probe(struct fbtft_par *par)
+{
+	struct spi_device *spi = par->spi;
+	struct device *dev = par->info->device;
+	int ret;
+
+	/* checks the word size against what the master supports */
+	spi->bits_per_word = 16;
+	ret = spi_setup(spi);
+	spi->bits_per_word = 8;
+	if (spi_setup(spi))
+		return -EINVAL;
+	if (ret)
+		return 0;
+
+	if (dma && zerocopy && !par->vmem_sg.nents) {
+		ret = fbtft_vmem_sg_map(par, spi, par->info->fix.smem_len);
+		if (ret && ret != -ENODEV)
+			dev_warn(dev, "failed to map video memory for DMA\n");
+	}
+	/* the unbuffered write can't use 16-bit words */
+	if (!par->vmem_sg.nents && !par->txbuf.buf)
+		return 0;
+
+	par->spi16 = true;
+	fbtft_par_dbg(DEBUG_DRIVER_INIT_FUNCTIONS, par,
+		"sending pixels as 16-bit SPI words\n");
+
+	return 0;
+}
+
 /**
  * fbtft_probe_common() - Generic device probe() helper function
  * @display: Display properties
@@ -1409,13 +2967,17 @@ int fbtft_probe_common(struct fbtft_display *display,
 	/* write register functions */
 	if (display->regwidth == 8 && display->buswidth == 8) {
 		par->fbtftops.write_register = fbtft_write_reg8_bus8;
+		par->fbtftops.write_register_buf = fbtft_write_reg8_bus8_buf;
 	} else
 	if (display->regwidth == 8 && display->buswidth == 9 && par->spi) {
 		par->fbtftops.write_register = fbtft_write_reg8_bus9;
+		par->fbtftops.write_register_buf = fbtft_write_reg8_bus9_buf;
 	} else if (display->regwidth == 16 && display->buswidth == 8) {
 		par->fbtftops.write_register = fbtft_write_reg16_bus8;
+		par->fbtftops.write_register_buf = fbtft_write_reg16_bus8_buf;
 	} else if (display->regwidth == 16 && display->buswidth == 16) {
 		par->fbtftops.write_register = fbtft_write_reg16_bus16;
+		par->fbtftops.write_register_buf = fbtft_write_reg16_bus16_buf;
 	} else {
 		dev_warn(dev,
 			"no default functions for regwidth=%d and buswidth=%d\n",
@@ -1458,6 +3020,8 @@ int fbtft_probe_common(struct fbtft_display *display,
 				goto out_release;
 			}
 			par->fbtftops.write = fbtft_write_spi_emulate_9;
+			/* emulation needs transfers in multiples of 8 bytes */
+			par->caps &= ~FBTFT_CAP_ADDR_WIN_X;
 		}
 	}
 
@@ -1474,6 +3038,16 @@ int fbtft_probe_common(struct fbtft_display *display,
 	/* use platform_data provided functions above all */
 	fbtft_merge_fbtftops(&par->fbtftops, &pdata->display.fbtftops);
 
+	if (spi16 && par->spi && display->buswidth == 8 && !par->startbyte &&
+	    par->fbtftops.write == fbtft_write_spi &&
+	    par->fbtftops.write_vmem == fbtft_write_vmem16_bus8 &&
+	    par->info->var.bits_per_pixel == 16 &&
+	    !par->bigendian && !par->littleendian) {
+		ret = fbtft_spi16_probe(par);
+		if (ret)
+			goto out_release;
+	}
+
 	ret = fbtft_register_framebuffer(info);
 	if (ret < 0)
 		goto out_release;
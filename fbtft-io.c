@@ -2,37 +2,257 @@
 #include <linux/errno.h>
 #include <linux/gpio.h>
 #include <linux/spi/spi.h>
+#include <linux/dma-mapping.h>
+#include <linux/highmem.h>
 #ifdef CONFIG_ARCH_BCM2708
 #include <mach/platform.h>
 #endif
 #include "fbtft.h"
 
-int fbtft_write_spi(struct fbtft_par *par, void *buf, size_t len)
+/**
+ * fbtft_txbuf_sync_for_device() - Hand a transmit buffer to the device
+ * @par: Driver data
+ * @dma: DMA address of the transmit buffer
+ * @len: Number of bytes to be transferred
+ *
+ * Does nothing unless the transmit buffers are streaming DMA mappings.
+ */
+void fbtft_txbuf_sync_for_device(struct fbtft_par *par, dma_addr_t dma,
+								size_t len)
+{
+	if (par->txbuf.streaming && dma)
+		dma_sync_single_for_device(par->info->device, dma, len,
+							DMA_TO_DEVICE);
+}
+EXPORT_SYMBOL(fbtft_txbuf_sync_for_device);
+
+/**
+ * fbtft_txbuf_sync_for_cpu() - Take a transmit buffer back after a transfer
+ * @par: Driver data
+ * @dma: DMA address of the transmit buffer
+ * @len: Number of bytes transferred
+ */
+void fbtft_txbuf_sync_for_cpu(struct fbtft_par *par, dma_addr_t dma,
+								size_t len)
+{
+	if (par->txbuf.streaming && dma)
+		dma_sync_single_for_cpu(par->info->device, dma, len,
+							DMA_TO_DEVICE);
+}
+EXPORT_SYMBOL(fbtft_txbuf_sync_for_cpu);
+
+static int fbtft_write_spi_bpw(struct fbtft_par *par, void *buf, size_t len,
+								u8 bpw)
 {
-	struct spi_transfer t = {
-		.tx_buf = buf,
-		.len = len,
-	};
+	struct spi_transfer single;
+	struct spi_transfer *t = &single;
 	struct spi_message m;
+	bool is_txbuf = buf == par->txbuf.buf;
+	size_t chunk = len;
+	size_t pos = 0;
+	size_t n;
+	int ret;
+
+	if (!par->spi) {
+		dev_err(par->info->device,
+			"%s: par->spi is unexpectedly NULL\n", __func__);
+		return -1;
+	}
+
+	/* the whole transmit buffer in one message, chained in chunks */
+	if (is_txbuf && par->chain.num) {
+		t = par->chain.xfer;
+		chunk = par->chain.chunk;
+	}
+
+	spi_message_init(&m);
+	if (par->txbuf.dma && is_txbuf) {
+		m.is_dma_mapped = 1;
+		fbtft_txbuf_sync_for_device(par, par->txbuf.dma, len);
+	}
+	do {
+		n = min(len - pos, chunk);
+		memset(t, 0, sizeof(*t));
+		t->tx_buf = buf + pos;
+		t->len = n;
+		t->bits_per_word = bpw;
+		if (m.is_dma_mapped)
+			t->tx_dma = par->txbuf.dma + pos;
+		spi_message_add_tail(t++, &m);
+		pos += n;
+	} while (pos < len);
+
+	ret = spi_sync(par->spi, &m);
+	if (m.is_dma_mapped)
+		fbtft_txbuf_sync_for_cpu(par, par->txbuf.dma, len);
 
+	return ret;
+}
+
+int fbtft_write_spi(struct fbtft_par *par, void *buf, size_t len)
+{
 	fbtft_par_dbg_hex(DEBUG_WRITE, par, par->info->device, u8, buf, len,
 		"%s(len=%d): ", __func__, len);
 
+	return fbtft_write_spi_bpw(par, buf, len, 0);
+}
+EXPORT_SYMBOL(fbtft_write_spi);
+
+/**
+ * fbtft_write_spi16() - Write native 16-bit words, MSB first
+ * @par: Driver data
+ * @buf: Buffer to write
+ * @len: Number of bytes to write, even
+ *
+ * Only to be used when @par->spi16 is set.
+ */
+int fbtft_write_spi16(struct fbtft_par *par, void *buf, size_t len)
+{
+	fbtft_par_dbg_hex(DEBUG_WRITE, par, par->info->device, u16, buf, len,
+		"%s(len=%d): ", __func__, len);
+
+	return fbtft_write_spi_bpw(par, buf, len, 16);
+}
+EXPORT_SYMBOL(fbtft_write_spi16);
+
+static void fbtft_write_spi_complete(void *context)
+{
+	struct fbtft_pipe_xfer *x = context;
+
+	complete(&x->done);
+}
+
+/**
+ * fbtft_write_spi_async() - Start an asynchronous SPI write
+ * @par: Driver data
+ * @x: Pipeline slot, @x->buf holds the data
+ * @len: Number of bytes to write
+ *
+ * @x->buf holds pixels, sent in 16-bit words if @par->spi16 is set.
+ * The transfer must be waited for with fbtft_write_spi_wait() before
+ * @x->buf is reused or something else is written to the bus.
+ */
+int fbtft_write_spi_async(struct fbtft_par *par, struct fbtft_pipe_xfer *x,
+								size_t len)
+{
+	int ret;
+
+	fbtft_par_dbg_hex(DEBUG_WRITE, par, par->info->device, u8, x->buf, len,
+		"%s(len=%d): ", __func__, len);
+
 	if (!par->spi) {
 		dev_err(par->info->device,
 			"%s: par->spi is unexpectedly NULL\n", __func__);
 		return -1;
 	}
 
+	memset(&x->xfer, 0, sizeof(x->xfer));
+	x->xfer.tx_buf = x->buf;
+	x->xfer.len = len;
+	if (par->spi16)
+		x->xfer.bits_per_word = 16;
+	spi_message_init(&x->msg);
+	if (x->dma) {
+		x->xfer.tx_dma = x->dma;
+		x->msg.is_dma_mapped = 1;
+		fbtft_txbuf_sync_for_device(par, x->dma, len);
+	}
+	spi_message_add_tail(&x->xfer, &x->msg);
+	x->msg.complete = fbtft_write_spi_complete;
+	x->msg.context = x;
+	init_completion(&x->done);
+
+	ret = spi_async(par->spi, &x->msg);
+	if (ret == 0)
+		x->busy = true;
+
+	return ret;
+}
+EXPORT_SYMBOL(fbtft_write_spi_async);
+
+/**
+ * fbtft_write_spi_wait() - Wait for an asynchronous SPI write
+ * @par: Driver data
+ * @x: Pipeline slot
+ *
+ * Return: 0 if idle or the transfer succeeded, negative if error
+ */
+int fbtft_write_spi_wait(struct fbtft_par *par, struct fbtft_pipe_xfer *x)
+{
+	if (!x->busy)
+		return 0;
+
+	wait_for_completion(&x->done);
+	x->busy = false;
+	fbtft_txbuf_sync_for_cpu(par, x->dma, x->xfer.len);
+
+	return x->msg.status;
+}
+EXPORT_SYMBOL(fbtft_write_spi_wait);
+
+/**
+ * fbtft_write_spi_vmem_sg() - Write video memory using its DMA mapping
+ * @par: Driver data
+ * @offset: Video memory offset
+ * @len: Number of bytes to write
+ *
+ * Sends video memory as is, in one message with a transfer for each
+ * mapped chunk of @par->vmem_sg.table, so no bounce buffer is needed.
+ * The transfers use 16-bit words if @par->spi16 is set.
+ */
+int fbtft_write_spi_vmem_sg(struct fbtft_par *par, size_t offset, size_t len)
+{
+	struct spi_transfer *t = par->vmem_sg.xfer;
+	struct scatterlist *sg;
+	struct spi_message m;
+	size_t pos = 0;
+	size_t start, end;
+	unsigned first, count;
+	int i;
+
+	fbtft_par_dbg(DEBUG_WRITE, par, "%s(offset=%zu, len=%zu)\n",
+		__func__, offset, len);
+
+	if (!par->spi || !par->vmem_sg.nents)
+		return -EINVAL;
+
+	/* push out the vmalloc alias before syncing the pages */
+	flush_kernel_vmap_range(par->info->screen_base + offset, len);
+
+	/* one page per entry, sync the ones the window touches */
+	first = offset / PAGE_SIZE;
+	count = DIV_ROUND_UP(offset + len, PAGE_SIZE) - first;
+	sg = par->vmem_sg.table.sgl;
+	for (i = 0; i < first; i++)
+		sg = sg_next(sg);
+	dma_sync_sg_for_device(par->vmem_sg.dev, sg, count, DMA_TO_DEVICE);
+
 	spi_message_init(&m);
-	if (par->txbuf.dma && buf == par->txbuf.buf) {
-		t.tx_dma = par->txbuf.dma;
-		m.is_dma_mapped = 1;
+	m.is_dma_mapped = 1;
+	for_each_sg(par->vmem_sg.table.sgl, sg, par->vmem_sg.nents, i) {
+		size_t base = pos;
+
+		pos += sg_dma_len(sg);
+		start = max(base, offset);
+		end = min(pos, offset + len);
+		if (start >= end)
+			continue;
+
+		memset(t, 0, sizeof(*t));
+		t->tx_buf = par->info->screen_base + start;
+		t->tx_dma = sg_dma_address(sg) + (start - base);
+		t->len = end - start;
+		if (par->spi16)
+			t->bits_per_word = 16;
+		spi_message_add_tail(t, &m);
+		t++;
+		if (pos >= offset + len)
+			break;
 	}
-	spi_message_add_tail(&t, &m);
+
 	return spi_sync(par->spi, &m);
 }
-EXPORT_SYMBOL(fbtft_write_spi);
+EXPORT_SYMBOL(fbtft_write_spi_vmem_sg);
 
 /**
  * fbtft_write_spi_emulate_9() - write SPI emulating 9-bit
@@ -129,6 +349,26 @@ int fbtft_read_spi(struct fbtft_par *par, void *buf, size_t len)
 }
 EXPORT_SYMBOL(fbtft_read_spi);
 
+/*
+ * Reads len bytes after sending the command byte reg, keeping chip select
+ * asserted in between. Needs a D/C gpio (4-wire SPI).
+ */
+int fbtft_read_reg8_spi(struct fbtft_par *par, u8 reg, void *buf, size_t len)
+{
+	int ret;
+
+	if (!par->spi || par->gpio.dc == -1 || par->startbyte)
+		return -EOPNOTSUPP;
+
+	gpio_set_value(par->gpio.dc, 0);
+	ret = spi_write_then_read(par->spi, &reg, 1, buf, len);
+	fbtft_par_dbg_hex(DEBUG_READ, par, par->info->device, u8, buf, len,
+		"%s(reg=0x%02X, len=%d) buf <= ", __func__, reg, len);
+
+	return ret;
+}
+EXPORT_SYMBOL(fbtft_read_reg8_spi);
+
 
 #ifdef CONFIG_ARCH_BCM2708
 
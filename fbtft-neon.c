@@ -0,0 +1,44 @@
+/*
+ * NEON RGB565 conversion, see fbtft-bus.c
+ *
+ * Built with NEON enabled, so these must only be called between
+ * kernel_neon_begin() and kernel_neon_end().
+ */
+#include <arm_neon.h>
+
+void fbtft_swab16_neon(uint16_t *dst, const uint16_t *src, unsigned long n);
+void fbtft_bus9_neon(uint16_t *dst, const uint16_t *src, unsigned long n);
+
+/* n is a multiple of 16 */
+void fbtft_swab16_neon(uint16_t *dst, const uint16_t *src, unsigned long n)
+{
+	const uint8_t *s = (const uint8_t *)src;
+	uint8_t *d = (uint8_t *)dst;
+
+	for (; n; n -= 16) {
+		uint8x16_t a = vld1q_u8(s);
+		uint8x16_t b = vld1q_u8(s + 16);
+
+		vst1q_u8(d, vrev16q_u8(a));
+		vst1q_u8(d + 16, vrev16q_u8(b));
+		s += 32;
+		d += 32;
+	}
+}
+
+/* n is a multiple of 8, little endian only */
+void fbtft_bus9_neon(uint16_t *dst, const uint16_t *src, unsigned long n)
+{
+	const uint8_t *s = (const uint8_t *)src;
+	uint8_t *d = (uint8_t *)dst;
+	uint8x16x2_t v;
+
+	/* interleave high byte, dc, low byte, dc */
+	v.val[1] = vdupq_n_u8(0x01);
+	for (; n; n -= 8) {
+		v.val[0] = vrev16q_u8(vld1q_u8(s));
+		vst2q_u8(d, v);
+		s += 16;
+		d += 32;
+	}
+}
@@ -206,17 +206,244 @@ static ssize_t show_debug(struct device *device,
 static struct device_attribute debug_device_attr = \
 	__ATTR(debug, 0660, show_debug, store_debug);
 
+static ssize_t store_shadow(struct device *device,
+				struct device_attribute *attr,
+				const char *buf, size_t count)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+	bool enable;
+	int ret;
+
+	ret = strtobool(buf, &enable);
+	if (ret)
+		return ret;
+	ret = fbtft_shadow_set(par, enable);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
+static ssize_t show_shadow(struct device *device,
+				struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", par->shadow.buf ? 1 : 0);
+}
+
+static ssize_t show_bytes_sent(struct device *device,
+				struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+
+	return snprintf(buf, PAGE_SIZE, "%llu\n", par->bytes_sent);
+}
+
+static ssize_t show_bytes_saved(struct device *device,
+				struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+
+	return snprintf(buf, PAGE_SIZE, "%llu\n", par->shadow.saved);
+}
+
+static ssize_t store_worker_prio(struct device *device,
+				struct device_attribute *attr,
+				const char *buf, size_t count)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+	int prio, ret;
+
+	ret = kstrtoint(buf, 10, &prio);
+	if (ret)
+		return ret;
+	ret = fbtft_worker_set_sched(par, prio, par->update.cpu);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
+static ssize_t show_worker_prio(struct device *device,
+				struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", par->update.prio);
+}
+
+static ssize_t store_worker_cpu(struct device *device,
+				struct device_attribute *attr,
+				const char *buf, size_t count)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+	int cpu, ret;
+
+	ret = kstrtoint(buf, 10, &cpu);
+	if (ret)
+		return ret;
+	ret = fbtft_worker_set_sched(par, par->update.prio, cpu);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
+static ssize_t show_worker_cpu(struct device *device,
+				struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", par->update.cpu);
+}
+
+static ssize_t store_fps(struct device *device,
+				struct device_attribute *attr,
+				const char *buf, size_t count)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+	unsigned fps;
+	int ret;
+
+	ret = kstrtouint(buf, 10, &fps);
+	if (ret)
+		return ret;
+	fbtft_set_fps(par, fps);
+
+	return count;
+}
+
+static ssize_t show_fps(struct device *device,
+				struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", par->update.fps);
+}
+
+static ssize_t show_fps_achieved(struct device *device,
+				struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+	unsigned mhz = par->update.fps_achieved;
+
+	return snprintf(buf, PAGE_SIZE, "%u.%03u\n", mhz / 1000, mhz % 1000);
+}
+
+static ssize_t show_fps_target(struct device *device,
+				struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+	unsigned long target = par->update.target;
+	unsigned mhz = target ? div_u64(NSEC_PER_SEC * 1000ULL, target) : 0;
+
+	return snprintf(buf, PAGE_SIZE, "%u.%03u\n", mhz / 1000, mhz % 1000);
+}
+
+static ssize_t show_throughput(struct device *device,
+				struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+
+	return snprintf(buf, PAGE_SIZE, "%lu\n", par->update.throughput);
+}
+
+static ssize_t store_manual(struct device *device,
+				struct device_attribute *attr,
+				const char *buf, size_t count)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+	bool manual;
+	int ret;
+
+	ret = strtobool(buf, &manual);
+	if (ret)
+		return ret;
+	par->manual = manual;
+
+	return count;
+}
+
+static ssize_t show_manual(struct device *device,
+				struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", par->manual);
+}
+
+static ssize_t show_frames_pushed(struct device *device,
+				struct device_attribute *attr, char *buf)
+{
+	struct fb_info *fb_info = dev_get_drvdata(device);
+	struct fbtft_par *par = fb_info->par;
+
+	return snprintf(buf, PAGE_SIZE, "%lu\n", par->update.pushed);
+}
+
+static struct device_attribute worker_device_attrs[] = {
+	__ATTR(worker_prio, 0660, show_worker_prio, store_worker_prio),
+	__ATTR(worker_cpu, 0660, show_worker_cpu, store_worker_cpu),
+};
+
+static struct device_attribute update_device_attrs[] = {
+	__ATTR(fps, 0660, show_fps, store_fps),
+	__ATTR(fps_achieved, 0440, show_fps_achieved, NULL),
+	__ATTR(fps_target, 0440, show_fps_target, NULL),
+	__ATTR(throughput, 0440, show_throughput, NULL),
+	__ATTR(manual, 0660, show_manual, store_manual),
+	__ATTR(frames_pushed, 0440, show_frames_pushed, NULL),
+};
+
+static struct device_attribute shadow_device_attrs[] = {
+	__ATTR(shadow, 0660, show_shadow, store_shadow),
+	__ATTR(bytes_sent, 0440, show_bytes_sent, NULL),
+	__ATTR(bytes_saved, 0440, show_bytes_saved, NULL),
+};
+
 
 void fbtft_sysfs_init(struct fbtft_par *par)
 {
+	int i;
+
 	device_create_file(par->info->dev, &debug_device_attr);
+	for (i = 0; i < ARRAY_SIZE(shadow_device_attrs); i++)
+		device_create_file(par->info->dev, &shadow_device_attrs[i]);
+	for (i = 0; i < ARRAY_SIZE(worker_device_attrs); i++)
+		device_create_file(par->info->dev, &worker_device_attrs[i]);
+	for (i = 0; i < ARRAY_SIZE(update_device_attrs); i++)
+		device_create_file(par->info->dev, &update_device_attrs[i]);
 	if (par->gamma.curves && par->fbtftops.set_gamma)
 		device_create_file(par->info->dev, &gamma_device_attrs[0]);
 }
 
 void fbtft_sysfs_exit(struct fbtft_par *par)
 {
+	int i;
+
 	device_remove_file(par->info->dev, &debug_device_attr);
+	for (i = 0; i < ARRAY_SIZE(shadow_device_attrs); i++)
+		device_remove_file(par->info->dev, &shadow_device_attrs[i]);
+	for (i = 0; i < ARRAY_SIZE(worker_device_attrs); i++)
+		device_remove_file(par->info->dev, &worker_device_attrs[i]);
+	for (i = 0; i < ARRAY_SIZE(update_device_attrs); i++)
+		device_remove_file(par->info->dev, &update_device_attrs[i]);
 	if (par->gamma.curves && par->fbtftops.set_gamma)
 		device_remove_file(par->info->dev, &gamma_device_attrs[0]);
 }
@@ -21,9 +21,16 @@
 
 #include <linux/fb.h>
 #include <linux/spinlock.h>
+#include <linux/completion.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/wait.h>
+#include <linux/scatterlist.h>
 #include <linux/spi/spi.h>
 #include <linux/platform_device.h>
 
+#include "fbtft_ioctl.h"
+
 
 #define FBTFT_NOP		0x00
 #define FBTFT_SWRESET	0x01
@@ -32,17 +39,60 @@
 #define FBTFT_CASET		0x2A
 #define FBTFT_RASET		0x2B
 #define FBTFT_RAMWR		0x2C
+#define FBTFT_RAMWR_CONT	0x3C
 
 #define FBTFT_ONBOARD_BACKLIGHT 2
 
 #define FBTFT_GPIO_NO_MATCH		0xFFFF
 #define FBTFT_GPIO_NAME_SIZE	32
 #define FBTFT_MAX_INIT_SEQUENCE      512
+#define FBTFT_MAX_REG_VALUES         64
 #define FBTFT_GAMMA_MAX_VALUES_TOTAL 128
 
 #define FBTFT_OF_INIT_CMD	BIT(24)
 #define FBTFT_OF_INIT_DELAY	BIT(25)
 
+/* Controller capabilities, see @caps in struct fbtft_display */
+#define FBTFT_CAP_ADDR_WIN_X	BIT(0)	/* set_addr_win() honours xs/xe */
+#define FBTFT_CAP_TE		BIT(1)	/* MIPI DCS tearing effect, 0x35/0x45 */
+#define FBTFT_CAP_LITTLE_ENDIAN	BIT(2)	/* takes RGB565 low byte first (parallel) */
+#define FBTFT_CAP_RAMWR_CONT	BIT(3)	/* MIPI DCS write_memory_continue */
+
+/* Longest wait for the panel to start a new frame */
+#define FBTFT_TE_TIMEOUT_MS	50
+
+/*
+ * Scanline polling gives up on a poll after this many reads of the same
+ * line, and stops polling after this many polls in a row that didn't see
+ * the scanline wrap (no MISO, or a controller that doesn't implement it)
+ */
+#define FBTFT_TE_POLL_SAME	64
+#define FBTFT_TE_POLL_FAILS	3
+
+/* Damage list: max windows per update and their cost in bus bytes */
+#define FBTFT_DAMAGE_MAX	8
+#define FBTFT_DAMAGE_WIN_COST	512	/* set_addr_win() */
+#define FBTFT_DAMAGE_LINE_COST	32	/* write_vmem() per partial line */
+
+/* Number of transmit buffers used by pipelined write_vmem() */
+#define FBTFT_PIPE_DEPTH	2
+
+/* Tile size in pixels used when comparing with the shadow frame */
+#define FBTFT_TILE_SIZE		16
+
+/* Max drawing operations queued for the controller between updates */
+#define FBTFT_ACCEL_MAX		16
+
+/* Command queue size, segments and command/parameter bytes */
+#define FBTFT_CMDQ_SEGS		16
+#define FBTFT_CMDQ_BYTES	256
+
+/*
+ * var.nonstd of RGB565 video memory in bus (big endian) byte order.
+ * The color bitfields describe the big endian 16-bit pixel.
+ */
+#define FBTFT_NONSTD_BE565	2
+
 /**
  * struct fbtft_gpio - Structure that holds one pinname to gpio mapping
  * @name: pinname (reset, dc, etc.)
@@ -54,6 +104,110 @@ struct fbtft_gpio {
 	unsigned gpio;
 };
 
+/**
+ * struct fbtft_rect - Display area, all coordinates are inclusive
+ * @xs: First column
+ * @ys: First line
+ * @xe: Last column
+ * @ye: Last line
+ */
+struct fbtft_rect {
+	unsigned xs;
+	unsigned ys;
+	unsigned xe;
+	unsigned ye;
+};
+
+/**
+ * struct fbtft_damage - List of display areas waiting to be updated
+ * @rect: Damaged windows, coalesced by fbtft_damage_add()
+ * @num: Number of windows in use
+ */
+struct fbtft_damage {
+	struct fbtft_rect rect[FBTFT_DAMAGE_MAX];
+	unsigned num;
+};
+
+/**
+ * struct fbtft_pipe_xfer - Transmit buffer used by pipelined SPI writes
+ * @buf: Transmit buffer, par->txbuf.len bytes
+ * @dma: DMA address of @buf, 0 if not DMA mapped
+ * @xfer: SPI transfer
+ * @msg: SPI message
+ * @done: Completed when @msg has been transferred
+ * @busy: @msg is submitted and has not been waited for
+ */
+struct fbtft_pipe_xfer {
+	void *buf;
+	dma_addr_t dma;
+	struct spi_transfer xfer;
+	struct spi_message msg;
+	struct completion done;
+	bool busy;
+};
+
+/**
+ * struct fbtft_cmdq_seg - Bytes sent with one Data/Command level
+ * @buf: Bytes to send
+ * @len: Number of bytes
+ * @dma: DMA address of @buf, 0 if not DMA mapped
+ * @bpw: SPI word size, 0 for the device's
+ * @dc: Level of the Data/Command signal
+ */
+struct fbtft_cmdq_seg {
+	const void *buf;
+	size_t len;
+	dma_addr_t dma;
+	u8 bpw;
+	bool dc;
+};
+
+/**
+ * struct fbtft_cmdq - Register writes queued to be sent at once
+ * @seg: Queued segments
+ * @num: Number of segments in @seg
+ * @data: Command and parameter bytes of the segments
+ * @used: Bytes used in @data
+ * @xfer: One transfer for each segment
+ * @msg: Messages, one for each run of segments with the same level
+ * @cur: Message to use for the next run
+ * @next: First segment of the next run
+ * @status: Error while sending the queue
+ * @error: First error of a flush done to make room, for fbtft_cmdq_submit()
+ * @done: Completed when the whole queue has been sent
+ * @enabled: Display can use the queue (8-bit SPI, non-sleeping DC)
+ * @open: write_reg() appends to the queue instead of writing
+ */
+struct fbtft_cmdq {
+	struct fbtft_cmdq_seg seg[FBTFT_CMDQ_SEGS];
+	unsigned num;
+	u8 data[FBTFT_CMDQ_BYTES];
+	size_t used;
+	struct spi_transfer xfer[FBTFT_CMDQ_SEGS];
+	struct spi_message msg[2];
+	unsigned cur;
+	unsigned next;
+	int status;
+	int error;
+	struct completion done;
+	bool enabled;
+	bool open;
+};
+
+/**
+ * struct fbtft_accel - Drawing operation done by the controller
+ * @is_copy: @copy is valid, otherwise @fill
+ * @fill: Rectangle to fill, @fill.color is the pixel value
+ * @copy: Area to copy
+ */
+struct fbtft_accel {
+	bool is_copy;
+	union {
+		struct fb_fillrect fill;
+		struct fb_copyarea copy;
+	};
+};
+
 struct fbtft_par;
 
 /**
@@ -62,9 +216,11 @@ struct fbtft_par;
  * @read: Reads from interface bus
  * @write_vmem: Writes video memory to display
  * @write_reg: Writes to controller register
+ * @write_register_buf: Writes to controller register, register and values
+ *                      from an array
  * @set_addr_win: Set the GRAM update window
  * @reset: Reset the LCD controller
- * @mkdirty: Marks display lines for update
+ * @mkdirty: Marks display area for update
  * @update_display: Updates the display
  * @init_display: Initializes the display
  * @blank: Blank the display (optional)
@@ -77,6 +233,10 @@ struct fbtft_par;
  * @set_var: Configure LCD with values from variables like @rotate and @bgr
  *           (optional)
  * @set_gamma: Set Gamma curve (optional)
+ * @set_scroll: Show video memory line @yoffset at the top of the display,
+ *              for rotate 0 and 180 (optional)
+ * @fillrect: Fill a rectangle on the display with the controller (optional)
+ * @copyarea: Copy an area on the display with the controller (optional)
  *
  * Most of these operations have default functions assigned to them in
  *     fbtft_framebuffer_alloc()
@@ -86,13 +246,16 @@ struct fbtft_ops {
 	int (*read)(struct fbtft_par *par, void *buf, size_t len);
 	int (*write_vmem)(struct fbtft_par *par, size_t offset, size_t len);
 	void (*write_register)(struct fbtft_par *par, int len, ...);
+	void (*write_register_buf)(struct fbtft_par *par, const u16 *vals,
+		int len);
 
 	void (*set_addr_win)(struct fbtft_par *par,
 		int xs, int ys, int xe, int ye);
 	void (*reset)(struct fbtft_par *par);
-	void (*mkdirty)(struct fb_info *info, int from, int to);
+	void (*mkdirty)(struct fb_info *info, int x, int y,
+				int width, int height);
 	void (*update_display)(struct fbtft_par *par,
-				unsigned start_line, unsigned end_line);
+				unsigned xs, unsigned ys, unsigned xe, unsigned ye);
 	int (*init_display)(struct fbtft_par *par);
 	int (*blank)(struct fbtft_par *par, bool on);
 
@@ -106,6 +269,10 @@ struct fbtft_ops {
 
 	int (*set_var)(struct fbtft_par *par);
 	int (*set_gamma)(struct fbtft_par *par, unsigned long *curves);
+	int (*set_scroll)(struct fbtft_par *par, unsigned yoffset);
+	int (*fillrect)(struct fbtft_par *par, const struct fb_fillrect *rect);
+	int (*copyarea)(struct fbtft_par *par,
+				const struct fb_copyarea *area);
 };
 
 /**
@@ -124,6 +291,7 @@ struct fbtft_ops {
  * @gamma_num: Number of Gamma curves
  * @gamma_len: Number of values per Gamma curve
  * @debug: Initial debug value
+ * @caps: Controller capabilities (FBTFT_CAP_*)
  *
  * This structure is not stored by FBTFT except for init_sequence.
  */
@@ -142,6 +310,7 @@ struct fbtft_display {
 	int gamma_num;
 	int gamma_len;
 	unsigned long debug;
+	unsigned long caps;
 };
 
 /**
@@ -150,6 +319,9 @@ struct fbtft_display {
  * @gpios: Pointer to an array of piname to gpio mappings
  * @rotate: Display rotation angle
  * @bgr: LCD Controller BGR bit
+ * @bigendian: Video memory holds RGB565 in bus byte order
+ * @littleendian: Send RGB565 low byte first, if the controller can take it
+ *                 (8-bit parallel bus only)
  * @fps: Frames per second (this will go away, use @fps in @fbtft_display)
  * @txbuflen: Size of transmit buffer
  * @startbyte: When set, enables use of Startbyte in transfers
@@ -161,6 +333,8 @@ struct fbtft_platform_data {
 	const struct fbtft_gpio *gpios;
 	unsigned rotate;
 	bool bgr;
+	bool bigendian;
+	bool littleendian;
 	unsigned fps;
 	int txbuflen;
 	u8 startbyte;
@@ -185,13 +359,56 @@ struct fbtft_platform_data {
  * @pseudo_palette: Used by fb_set_colreg()
  * @txbuf.buf: Transmit buffer
  * @txbuf.len: Transmit buffer length
+ * @txbuf.streaming: Transmit buffers are cached and DMA mapped for
+ *                   streaming, they are synced around each transfer
+ * @pipe: Transmit buffers for pipelined writes, pipe[0] is txbuf.
+ *        Not in use if pipe[1].buf is NULL
+ * @chain.xfer: Transfers for sending the transmit buffer in one message
+ * @chain.num: Number of transfers in @chain.xfer, 0 if not in use
+ * @chain.chunk: Maximum length of each transfer
+ * @cmdq: Register writes queued by set_addr_win() and init sequences
+ * @vmem_sg.table: Video memory pages, DMA mapped for the SPI controller
+ * @vmem_sg.dev: Device of the SPI controller, that does the DMA
+ * @vmem_sg.xfer: One transfer per mapped entry of @vmem_sg.table
+ * @vmem_sg.nents: Number of mapped entries, 0 if not in use
+ * @addr_win.xs: First column of the last programmed window, -1 if unknown
+ * @addr_win.ys: First line of the last programmed window, -1 if unknown
+ * @addr_win.xe: Last column of the last programmed window, -1 if unknown
+ * @addr_win.ye: Last line of the last programmed window, -1 if unknown
+ * @addr_win.next: Line the write pointer is at, in column @addr_win.xs.
+ *                 -1 if unknown, any write_reg() resets it
  * @buf: Small buffer used when writing init data over SPI
  * @startbyte: Used by some controllers when in SPI mode.
  *             Format: 6 bit Device id + RS bit + RW bit
  * @fbtftops: FBTFT operations provided by driver or device (platform_data)
- * @dirty_lock: Protects dirty_lines_start and dirty_lines_end
- * @dirty_lines_start: Where to begin updating display
- * @dirty_lines_end: Where to end updating display
+ * @dirty_lock: Protects damage and update.thread
+ * @damage_buf: Two damage lists, one is filled while the other one is sent
+ * @damage: Display areas to update on the next deferred io run.
+ *          One of @damage_buf
+ * @accel.buf: Two queues, one is filled while the other one is run
+ * @accel.op: Drawing operations to do on the next update, before @damage.
+ *            One of @accel.buf
+ * @accel.num: Number of operations in @accel.op
+ * @update.lock: Serializes display updates
+ * @update.thread: Update worker, NULL if deferred io updates the display
+ * @update.wait: Update worker waits here for damage
+ * @update.prio: SCHED_FIFO priority of the worker, 0 for SCHED_NORMAL
+ * @update.cpu: CPU the worker is bound to, -1 for any
+ * @update.fps: Requested update rate, 0 for as fast as the bus allows
+ * @update.period: Minimum time between updates in ns, 0 for no pacing
+ * @update.target: Governed time between updates in ns, at least @update.period
+ * @update.duration: Average update transfer time in ns
+ * @update.throughput: Average bus throughput in bytes per second
+ * @update.last: Start of the last update
+ * @update.window: Start of the current fps measurement window
+ * @update.frames: Updates in the current fps measurement window
+ * @update.fps_achieved: Measured update rate in mHz
+ * @update.pushed: Number of frames pushed to the display
+ * @update.push_wait: Woken up each time a frame has been pushed
+ * @update.yoffset: First line of the front buffer in video memory
+ * @update.now: Next update is a page flip, don't pace it
+ * @update.offset: Video memory offset of the frame being sent
+ * @update.scroll: Scroll position to set on the next update, -1 for none
  * @gpio.reset: GPIO used to reset display
  * @gpio.dc: Data/Command signal, also known as RS
  * @gpio.rd: Read latching signal
@@ -201,6 +418,11 @@ struct fbtft_platform_data {
  * @gpio.db[16]: Parallel databus
  * @gpio.led[16]: Led control signals
  * @gpio.aux[16]: Auxillary signals, not used by core
+ * @gpio.te: Tearing effect output from the panel
+ * @te.irq: Interrupt of @gpio.te, 0 if not in use
+ * @te.done: Completed on each tearing effect interrupt
+ * @te.poll: Poll the scanline instead of using @gpio.te
+ * @te.fails: Polls in a row that didn't see the scanline wrap
  * @init_sequence: Pointer to LCD initialization array
  * @gamma.lock: Mutex for Gamma curve locking
  * @gamma.curves: Pointer to Gamma curve array
@@ -210,7 +432,17 @@ struct fbtft_platform_data {
  * @current_debug:
  * @first_update_done: Used to only time the first display update
  * @update_time: Used to calculate 'fps' in debug output
+ * @bytes_sent: Video memory bytes transferred to the display
+ * @shadow.buf: Copy of the last transferred frame, NULL if not in use
+ * @shadow.saved: Bytes not transferred because their tile was unchanged
+ * @shadow.damage: Tiles of the window being updated that changed
+ * @manual: New mappings don't track writes, use FBTFT_IOCTL_FLUSH
+ * @defio_mmap: Deferred io mmap, used when not in manual update mode
  * @bgr: BGR mode/\n
+ * @bigendian: Video memory holds RGB565 in bus byte order, not the CPU's
+ * @littleendian: Controller is set up to take RGB565 low byte first
+ * @spi16: SPI master sends pixels as 16-bit words, commands stay 8-bit
+ * @caps: Controller capabilities (FBTFT_CAP_*)
  * @extra: Extra info needed by driver
  */
 struct fbtft_par {
@@ -224,13 +456,61 @@ struct fbtft_par {
 		void *buf;
 		dma_addr_t dma;
 		size_t len;
+		bool streaming;
 	} txbuf;
+	struct fbtft_pipe_xfer pipe[FBTFT_PIPE_DEPTH];
+	struct {
+		struct spi_transfer *xfer;
+		unsigned num;
+		size_t chunk;
+	} chain;
+	struct fbtft_cmdq cmdq;
+	struct {
+		struct sg_table table;
+		struct device *dev;
+		struct spi_transfer *xfer;
+		int nents;
+	} vmem_sg;
+	struct {
+		int xs;
+		int ys;
+		int xe;
+		int ye;
+		int next;
+	} addr_win;
 	u8 *buf;
 	u8 startbyte;
 	struct fbtft_ops fbtftops;
 	spinlock_t dirty_lock;
-	unsigned dirty_lines_start;
-	unsigned dirty_lines_end;
+	struct fbtft_damage damage_buf[2];
+	struct fbtft_damage *damage;
+	struct {
+		struct fbtft_accel buf[2][FBTFT_ACCEL_MAX];
+		struct fbtft_accel *op;
+		unsigned num;
+	} accel;
+	struct {
+		struct mutex lock;
+		struct task_struct *thread;
+		wait_queue_head_t wait;
+		int prio;
+		int cpu;
+		unsigned fps;
+		unsigned long period;
+		unsigned long target;
+		unsigned long duration;
+		unsigned long throughput;
+		ktime_t last;
+		ktime_t window;
+		unsigned frames;
+		unsigned fps_achieved;
+		unsigned long pushed;
+		wait_queue_head_t push_wait;
+		unsigned yoffset;
+		bool now;
+		size_t offset;
+		int scroll;
+	} update;
 	struct {
 		int reset;
 		int dc;
@@ -241,7 +521,14 @@ struct fbtft_par {
 		int db[16];
 		int led[16];
 		int aux[16];
+		int te;
 	} gpio;
+	struct {
+		int irq;
+		struct completion done;
+		bool poll;
+		unsigned fails;
+	} te;
 	int *init_sequence;
 	struct {
 		struct mutex lock;
@@ -252,7 +539,19 @@ struct fbtft_par {
 	unsigned long debug;
 	bool first_update_done;
 	struct timespec update_time;
+	u64 bytes_sent;
+	struct {
+		u8 *buf;
+		u64 saved;
+		struct fbtft_damage damage;
+	} shadow;
+	bool manual;
+	int (*defio_mmap)(struct fb_info *info, struct vm_area_struct *vma);
 	bool bgr;
+	bool bigendian;
+	bool littleendian;
+	bool spi16;
+	unsigned long caps;
 	void *extra;
 };
 
@@ -260,9 +559,16 @@ struct fbtft_par {
 
 #define write_reg(par, ...)                                              \
 do {                                                                     \
+	par->addr_win.next = -1;                                         \
 	par->fbtftops.write_register(par, NUMARGS(__VA_ARGS__), __VA_ARGS__); \
 } while (0)
 
+#define write_reg_buf(par, vals, len)                                    \
+do {                                                                     \
+	par->addr_win.next = -1;                                         \
+	par->fbtftops.write_register_buf(par, vals, len);                \
+} while (0)
+
 /* fbtft-core.c */
 extern void fbtft_dbg_hex(const struct device *dev,
 	int groupsize, void *buf, size_t len, const char *fmt, ...);
@@ -271,18 +577,45 @@ extern struct fb_info *fbtft_framebuffer_alloc(struct fbtft_display *display,
 extern void fbtft_framebuffer_release(struct fb_info *info);
 extern int fbtft_register_framebuffer(struct fb_info *fb_info);
 extern int fbtft_unregister_framebuffer(struct fb_info *fb_info);
+extern void fbtft_set_scroll_dcs(struct fbtft_par *par, unsigned lines,
+	unsigned line);
+extern void fbtft_set_addr_win(struct fbtft_par *par, int xs, int ys, int xe,
+	int ye);
+extern void fbtft_addr_win_set(struct fbtft_par *par, int xs, int ys, int xe,
+	int ye);
+extern void fbtft_addr_win_invalidate(struct fbtft_par *par);
+extern bool fbtft_addr_win_continues(struct fbtft_par *par, int xs, int ys,
+	int xe, int ye);
 extern void fbtft_register_backlight(struct fbtft_par *par);
 extern void fbtft_unregister_backlight(struct fbtft_par *par);
 extern int fbtft_init_display(struct fbtft_par *par);
 extern int fbtft_probe_common(struct fbtft_display *display,
 	struct spi_device *sdev, struct platform_device *pdev);
 extern int fbtft_remove_common(struct device *dev, struct fb_info *info);
+extern int fbtft_shadow_set(struct fbtft_par *par, bool enable);
+extern int fbtft_worker_set_sched(struct fbtft_par *par, int prio, int cpu);
+extern void fbtft_set_fps(struct fbtft_par *par, unsigned fps);
+extern void fbtft_damage_add(struct fbtft_par *par, struct fbtft_damage *damage,
+	unsigned xs, unsigned ys, unsigned xe, unsigned ye);
 
 /* fbtft-io.c */
 extern int fbtft_write_spi(struct fbtft_par *par, void *buf, size_t len);
+extern int fbtft_write_spi16(struct fbtft_par *par, void *buf, size_t len);
+extern void fbtft_txbuf_sync_for_device(struct fbtft_par *par,
+	dma_addr_t dma, size_t len);
+extern void fbtft_txbuf_sync_for_cpu(struct fbtft_par *par,
+	dma_addr_t dma, size_t len);
 extern int fbtft_write_spi_emulate_9(struct fbtft_par *par,
 	void *buf, size_t len);
+extern int fbtft_write_spi_async(struct fbtft_par *par,
+	struct fbtft_pipe_xfer *x, size_t len);
+extern int fbtft_write_spi_wait(struct fbtft_par *par,
+	struct fbtft_pipe_xfer *x);
+extern int fbtft_write_spi_vmem_sg(struct fbtft_par *par, size_t offset,
+	size_t len);
 extern int fbtft_read_spi(struct fbtft_par *par, void *buf, size_t len);
+extern int fbtft_read_reg8_spi(struct fbtft_par *par, u8 reg, void *buf,
+	size_t len);
 extern int fbtft_write_gpio8_wr(struct fbtft_par *par, void *buf, size_t len);
 extern int fbtft_write_gpio16_wr(struct fbtft_par *par, void *buf, size_t len);
 extern int fbtft_write_gpio16_wr_latched(struct fbtft_par *par,
@@ -297,6 +630,31 @@ extern void fbtft_write_reg8_bus8(struct fbtft_par *par, int len, ...);
 extern void fbtft_write_reg8_bus9(struct fbtft_par *par, int len, ...);
 extern void fbtft_write_reg16_bus8(struct fbtft_par *par, int len, ...);
 extern void fbtft_write_reg16_bus16(struct fbtft_par *par, int len, ...);
+extern void fbtft_write_reg8_bus8_buf(struct fbtft_par *par, const u16 *vals,
+	int len);
+extern void fbtft_write_reg8_bus9_buf(struct fbtft_par *par, const u16 *vals,
+	int len);
+extern void fbtft_write_reg16_bus8_buf(struct fbtft_par *par, const u16 *vals,
+	int len);
+extern void fbtft_write_reg16_bus16_buf(struct fbtft_par *par,
+	const u16 *vals, int len);
+extern void fbtft_cmdq_init(struct fbtft_par *par);
+extern bool fbtft_cmdq_open(struct fbtft_par *par);
+extern void fbtft_cmdq_add(struct fbtft_par *par, bool dc, const void *buf,
+	size_t len);
+extern void fbtft_cmdq_add_ref(struct fbtft_par *par, bool dc,
+	const void *buf, size_t len, dma_addr_t dma, u8 bpw);
+extern int fbtft_cmdq_flush(struct fbtft_par *par);
+extern int fbtft_cmdq_submit(struct fbtft_par *par);
+extern void fbtft_cpu_to_be16_buf(u16 *dst, const u16 *src, size_t n);
+extern void fbtft_cpu_to_bus9_buf(u16 *dst, const u16 *src, size_t n);
+extern void fbtft_benchmark_conversion(struct fbtft_par *par);
+
+/* fbtft-neon.c */
+extern void fbtft_swab16_neon(uint16_t *dst, const uint16_t *src,
+	unsigned long n);
+extern void fbtft_bus9_neon(uint16_t *dst, const uint16_t *src,
+	unsigned long n);
 
 
 #define FBTFT_REGISTER_DRIVER(_name, _compatible, _display)                \
@@ -398,6 +756,7 @@ module_exit(fbtft_driver_module_exit);
 #define DEBUG_FB_IMAGEBLIT          (1<<12)
 #define DEBUG_FB_SETCOLREG          (1<<13)
 #define DEBUG_FB_BLANK              (1<<14)
+#define DEBUG_FB_IOCTL              (1<<15)
 
 #define DEBUG_SYSFS                 (1<<16)
 
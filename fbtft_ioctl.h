@@ -0,0 +1,58 @@
+/*
+ * fbtft ioctl interface, shared with userspace
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __LINUX_FBTFT_IOCTL_H
+#define __LINUX_FBTFT_IOCTL_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/* Max rectangles in one FBTFT_IOCTL_FLUSH */
+#define FBTFT_FLUSH_MAX		16
+
+/**
+ * struct fbtft_flush_rect - Display area
+ * @x: First column
+ * @y: First line
+ * @width: Number of columns
+ * @height: Number of lines
+ */
+struct fbtft_flush_rect {
+	__u32 x;
+	__u32 y;
+	__u32 width;
+	__u32 height;
+};
+
+/* Layout of struct fbtft_flush, a changed layout gets a new version */
+#define FBTFT_FLUSH_VERSION	1
+
+/**
+ * struct fbtft_flush - Rectangles for FBTFT_IOCTL_FLUSH
+ * @version: FBTFT_FLUSH_VERSION, other versions are rejected with -EINVAL
+ * @num: Number of rectangles in @rect
+ * @rect: Display areas to update, clipped to the visible area
+ *
+ * 264 bytes, no padding.
+ */
+struct fbtft_flush {
+	__u32 version;
+	__u32 num;
+	struct fbtft_flush_rect rect[FBTFT_FLUSH_MAX];
+};
+
+/* Update the display areas right away, returns when they are sent */
+#define FBTFT_IOCTL_FLUSH	_IOW('F', 0xA0, struct fbtft_flush)
+
+#endif /* __LINUX_FBTFT_IOCTL_H */
@@ -375,6 +375,9 @@ static int flexfb_probe_common(struct spi_device *sdev, struct platform_device *
 	}
 	flex_display.width = width;
 	flex_display.height = height;
+	/* these set_addr_win() implementations can address a column window */
+	if (setaddrwin == 0 || setaddrwin == 3)
+		flex_display.caps |= FBTFT_CAP_ADDR_WIN_X;
 	fbtft_init_dbg(dev, "Display resolution: %dx%d\n", width, height);
 	fbtft_init_dbg(dev, "chip = %s\n", chip ? chip : "not set");
 	fbtft_init_dbg(dev, "setaddrwin = %d\n", setaddrwin);
@@ -398,9 +401,11 @@ static int flexfb_probe_common(struct spi_device *sdev, struct platform_device *
 	switch (regwidth) {
 	case 8:
 		par->fbtftops.write_register = fbtft_write_reg8_bus8;
+		par->fbtftops.write_register_buf = fbtft_write_reg8_bus8_buf;
 		break;
 	case 16:
 		par->fbtftops.write_register = fbtft_write_reg16_bus8;
+		par->fbtftops.write_register_buf = fbtft_write_reg16_bus8_buf;
 		break;
 	default:
 		dev_err(dev, "argument 'regwidth': %d is not supported.\n", regwidth);
@@ -422,6 +427,8 @@ static int flexfb_probe_common(struct spi_device *sdev, struct platform_device *
 				return -EINVAL;
 			}
 			par->fbtftops.write_register = fbtft_write_reg8_bus9;
+			par->fbtftops.write_register_buf =
+						fbtft_write_reg8_bus9_buf;
 			par->fbtftops.write_vmem = fbtft_write_vmem16_bus9;
 			sdev->bits_per_word=9;
 			ret = sdev->master->setup(sdev);
@@ -441,6 +448,8 @@ static int flexfb_probe_common(struct spi_device *sdev, struct platform_device *
 					goto out_release;
 				}
 				par->fbtftops.write = fbtft_write_spi_emulate_9;
+				/* emulation needs transfers in multiples of 8 bytes */
+				par->caps &= ~FBTFT_CAP_ADDR_WIN_X;
 			}
 			break;
 		default:
@@ -456,6 +465,8 @@ static int flexfb_probe_common(struct spi_device *sdev, struct platform_device *
 			break;
 		case 16:
 			par->fbtftops.write_register = fbtft_write_reg16_bus16;
+			par->fbtftops.write_register_buf =
+						fbtft_write_reg16_bus16_buf;
 			if (latched)
 				par->fbtftops.write = fbtft_write_gpio16_wr_latched;
 			else